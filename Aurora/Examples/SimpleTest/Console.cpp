@@ -622,6 +622,8 @@ void Console::ExecuteConsoleContext()
 
 		if( consoleProtectedExecutor.HasHadException() )
 		{
+			// the command may have crashed inside an entity ForEach
+			m_pEnv->sys->pEntitySystem->AbortIterations();
 			switch (consoleProtectedExecutor.ExceptionInfo.Type)
 			{
 			case RuntimeProtector::ESE_Unknown:
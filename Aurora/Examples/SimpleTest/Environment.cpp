@@ -19,12 +19,13 @@
 
 #include "../../Systems/Systems.h"
 
-#include "../../Systems/LogSystem/FileLogSystem/FileLogSystem.h"
+#include "../../Systems/LogSystem/AsyncLogSystem/AsyncLogSystem.h"
 #include "../../Systems/LogSystem/MultiLogSystem/MultiLogSystem.h"
 #include "../../Systems/LogSystem/RocketLogSystem/RocketLogSystem.h"
 #include "../../Systems/LogSystem/ThreadsafeLogSystem/ThreadsafeLogSystem.h"
 #include "../../Systems/TimeSystem/TimeSystem.h"
 #include "../../Systems/EntitySystem/EntitySystem.h"
+#include "../../Systems/UpdateScheduler/UpdateScheduler.h"
 #include "../../Systems/AssetSystem/AssetSystem.h"
 #include "../../RuntimeObjectSystem/ObjectFactorySystem/ObjectFactorySystem.h"
 #include "../../RuntimeObjectSystem/RuntimeObjectSystem.h"
@@ -44,7 +45,8 @@ Environment::Environment( IGame* pGame )
     // init AssetSystem first as this establishes the Asset dir used by many systems
 	sys->pAssetSystem = new AssetSystem("Assets");
 
-	FileLogSystem *pFileLog = new FileLogSystem();
+	// Written from a background thread so logging bursts during reloads don't stall frames
+	AsyncLogSystem *pFileLog = new AsyncLogSystem();
 	pFileLog->SetLogPath("Log.txt");
 	pFileLog->SetVerbosity(eLV_COMMENTS);
 	pFileLog->Log(eLV_EVENTS, "Started file logger\n");
@@ -76,6 +78,8 @@ Environment::Environment( IGame* pGame )
 
 	sys->pEntitySystem = new EntitySystem();
 
+	sys->pUpdateScheduler = new UpdateScheduler();
+
 	sys->pGUISystem = new GUISystem();
 
 
@@ -94,6 +98,7 @@ Environment::~Environment()
 	// Reverse order as a rule
 
 	delete sys->pGUISystem;
+	delete sys->pUpdateScheduler;
 	delete sys->pEntitySystem;
 	delete sys->pTimeSystem;
 	delete sys->pRuntimeObjectSystem;
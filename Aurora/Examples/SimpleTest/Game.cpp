@@ -43,6 +43,7 @@
 #include "../../Systems/IEntitySystem.h"
 #include "../../Systems/ITimeSystem.h"
 #include "../../Systems/IUpdateable.h"
+#include "../../Systems/IUpdateScheduler.h"
 #include "../../RuntimeObjectSystem/IObjectFactorySystem.h"
 #include "../../RuntimeObjectSystem/RuntimeObjectSystem.h"
 #include "../../Systems/IGUISystem.h"
@@ -71,25 +72,6 @@
 using FileSystemUtils::Path;
 
 
-void Game::EntityUpdateProtector::ProtectedFunc()
-{
-	for (size_t i=0; i<entities.Size(); ++i)
-	{
-		IAUEntity* pEnt = pEntitySystem->Get(entities[i]);
-		if (pEnt) // Safety check in case entity was deleted during this update by another object
-		{
-			IAUUpdateable* pUpdateable = pEnt->GetUpdateable();
-			if (pUpdateable)
-			{
-				// If dropped here after a runtime failure, your crash was likely
-				// somewhere directly in the pUpdatable object's Update method
-				pUpdateable->Update(fDeltaTime);
-			}
-		}
-	}
-}
-
-
 // Global pointer to Game object necessary so we can do callback to Game::MainLoop method
 // Could be dangerous if we're instantiating multiple Game objects for some reason
 static Game* g_pGame = NULL;
@@ -155,8 +137,6 @@ bool Game::Init()
 
 	m_pEnv->sys->pObjectFactorySystem->AddListener(this);
 
-	m_EntityUpdateProtector.pEntitySystem = m_pEnv->sys->pEntitySystem;
-
     m_pEnv->Init();
 	m_pConsole = new Console(m_pEnv, m_pRocketContext);
 
@@ -253,11 +233,7 @@ void Game::MainLoop()
 
 	pTimeSystem->StartFrame();
 
-	AUDynArray<AUEntityId> entities;
-	m_EntityUpdateProtector.pEntitySystem->GetAll(m_EntityUpdateProtector.entities);
-    m_EntityUpdateProtector.fDeltaTime = fClampedDelta;
-		
-    if (!m_pEnv->sys->pRuntimeObjectSystem->TryProtectedFunction( &m_EntityUpdateProtector ) )
+    if (!m_pEnv->sys->pUpdateScheduler->Update( m_pEnv->sys->pEntitySystem, m_pEnv->sys->pRuntimeObjectSystem, fClampedDelta ) )
 	{
 		m_pEnv->sys->pLogSystem->Log(eLV_ERRORS, "Have caught an exception in main entity Update loop, code will not be run until new compile - please fix.\n");
 	}
@@ -372,11 +348,24 @@ void Game::RenderWorld()
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc( GL_LESS );
 
-	m_pRenderContext->Render( m_pEnv->sys->pEntitySystem );
+	m_EntityRenderProtector.pRenderContext = m_pRenderContext;
+	m_EntityRenderProtector.pEntitySystem = m_pEnv->sys->pEntitySystem;
+	if( !m_pEnv->sys->pRuntimeObjectSystem->TryProtectedFunction( &m_EntityRenderProtector ) )
+	{
+		m_pEnv->sys->pLogSystem->Log(eLV_ERRORS, "Have caught an exception in entity Render, code will not be run until new compile - please fix.\n");
+		m_pEnv->sys->pEntitySystem->AbortIterations();
+	}
 	// End mesh draw
 
 }
 
+void Game::EntityRenderProtector::ProtectedFunc()
+{
+	// If dropped here after a runtime failure, your crash was likely
+	// somewhere directly in a renderable object's Render method
+	pRenderContext->Render( pEntitySystem );
+}
+
 void Game::RocketLibUpdate()
 {
 	// Push through any log messages before rendering
@@ -116,19 +116,18 @@ private:
 
 	float				m_GameSpeed;
 
-    // Local class definition for handling protected update
-    class EntityUpdateProtector : public RuntimeProtector
+    // Local class definition for handling protected render
+    class EntityRenderProtector : public RuntimeProtector
     {
     public:
-        AUDynArray<AUEntityId>  entities;
-        float                   fDeltaTime;
+        AURenderContext*        pRenderContext;
         IEntitySystem*          pEntitySystem;
     
     private:
         virtual void ProtectedFunc();
 
     };
-    EntityUpdateProtector m_EntityUpdateProtector;
+    EntityRenderProtector m_EntityRenderProtector;
 
 };
 
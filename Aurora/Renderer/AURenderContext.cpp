@@ -42,41 +42,36 @@ AURenderContext::~AURenderContext()
 {
 }
 
-AUDynArray<AUEntityId> g_entities;
-
-void AURenderContext::Render( IEntitySystem* pEntitySystem )
+struct RenderVisitor : public IAUEntityVisitor
 {
-	//loop through setting matrices and calling render.
-	pEntitySystem->GetAll( g_entities );
-
-	for( size_t i = 0; i < g_entities.Size(); ++i )
+	virtual void Visit( IAUEntity* pEntity )
 	{
-
-		IAUEntity* pEntity = pEntitySystem->Get( g_entities[ i ] );
-		IAURenderable* pRenderable = pEntity->GetRenderable();
-		if( pRenderable )
-		{
-			glPushMatrix();
-
-			glMatrixMode(GL_MODELVIEW);
-
-			// Translation
-			const AUVec3f& t = pEntity->GetPosition();
-			glTranslatef(	t.x, t.y, t.z );
-				
-			// Rotation
-			float fglMatrix[16];
-			pEntity->GetOrientation().LoadglObjectMatrix(fglMatrix);
-			glMultMatrixf(fglMatrix);
-
-			// Scale
-			glEnable(GL_NORMALIZE); // Needed so normals don't get wrecked by scaling - not sure how costly it is though
-			const AUVec3f& s = pEntity->GetScale();
-			glScalef(	s.x, s.y, s.z );
-
-			pRenderable->Render();
-			glPopMatrix();
-		}
+		glPushMatrix();
+
+		glMatrixMode(GL_MODELVIEW);
+
+		// Translation
+		const AUVec3f& t = pEntity->GetPosition();
+		glTranslatef(	t.x, t.y, t.z );
+			
+		// Rotation
+		float fglMatrix[16];
+		pEntity->GetOrientation().LoadglObjectMatrix(fglMatrix);
+		glMultMatrixf(fglMatrix);
+
+		// Scale
+		glEnable(GL_NORMALIZE); // Needed so normals don't get wrecked by scaling - not sure how costly it is though
+		const AUVec3f& s = pEntity->GetScale();
+		glScalef(	s.x, s.y, s.z );
+
+		pEntity->GetRenderable()->Render();
+		glPopMatrix();
 	}
+};
 
+void AURenderContext::Render( IEntitySystem* pEntitySystem )
+{
+	//loop through setting matrices and calling render.
+	RenderVisitor visitor;
+	pEntitySystem->ForEach( visitor, AU_ENTITY_FILTER_RENDERABLE );
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <fstream>
 #include <algorithm>
 #include "ICompilerLogger.h"
+#include "DependencyRecord.h"
 
 using namespace std;
 using namespace FileSystemUtils;
@@ -40,7 +41,8 @@ void BuildTool::Clean( const FileSystemUtils::Path& temporaryPath_ ) const
 	std::string obj_extension = m_Compiler.GetObjectFileExtension();
 	while( ++pathIter )
 	{
-		if( pathIter.GetPath().Extension() == obj_extension )
+		std::string extension = pathIter.GetPath().Extension();
+		if( extension == obj_extension || extension == DependencyRecord::GetExtension() || extension == ".gch" )
 		{
 			if( m_pLogger )
 			{
@@ -52,10 +54,29 @@ void BuildTool::Clean( const FileSystemUtils::Path& temporaryPath_ ) const
 }
 
 
+// Checks whether an object file can be used in place of compiling its source file. If the compiler
+// writes dependency records all dependencies and the compile command line are checked, otherwise
+// only the source file.
+static bool GetIsObjectFileUpToDate( const Path& sourceFile_, const Path& objectFile_, uint64_t compileCommandHash_ )
+{
+	FileSystemUtils::filetime_t objTime = objectFile_.GetLastWriteTime();
+	DependencyRecord record;
+	if( compileCommandHash_ && record.Load( DependencyRecord::GetRecordPath( objectFile_ ) ) )
+	{
+		return record.compileCommandHash == compileCommandHash_
+			&& record.GetAreDependenciesOlderThan( objTime );
+	}
+
+	// we only want to use the object file if it's newer than the source file
+	return objTime > sourceFile_.GetLastWriteTime();
+}
+
 void BuildTool::Initialise( ICompilerLogger * pLogger )
 {
 	m_pLogger = pLogger;
 	m_Compiler.Initialise(pLogger);
+	m_ObjectCache.Initialise(pLogger);
+	m_Compiler.SetObjectCache( &m_ObjectCache );
 }
 
 void BuildTool::BuildModule( const std::vector<FileToBuild>&		buildFileList_, 
@@ -64,7 +85,7 @@ void BuildTool::BuildModule( const std::vector<FileToBuild>&		buildFileList_,
 							 const FileSystemUtils::Path&			moduleName_  )
 {
 	// Initial version is very basic, simply compiles them.
-	Path objectFileExtension = m_Compiler.GetObjectFileExtension();
+	uint64_t compileCommandHash = m_Compiler.GetCompileCommandHash( compilerOptions_ );
 	vector<Path> compileFileList;			// List of files we pass to the compiler
 	compileFileList.reserve( buildFileList_.size() );
 	vector<Path> forcedCompileFileList;		// List of files which must be compiled even if object file exists
@@ -106,15 +127,12 @@ void BuildTool::BuildModule( const std::vector<FileToBuild>&		buildFileList_,
 		if( find( forcedCompileFileList.begin(), forcedCompileFileList.end(), buildFile ) == forcedCompileFileList.end() )
 		{
 			// Check if we have a pre-compiled object version of this file, and if so use that.
-			Path objectFileName = compilerOptions_.intermediatePath / buildFile.Filename();
-			objectFileName.ReplaceExtension(objectFileExtension.c_str());
+			Path objectFileName = m_Compiler.GetObjectFilePath( buildFile, compilerOptions_ );
 
 			if( objectFileName.Exists() && buildFile.Exists() )
             {
-                FileSystemUtils::filetime_t objTime = objectFileName.GetLastWriteTime();
-                if( objTime > buildFile.GetLastWriteTime() )
+                if( GetIsObjectFileUpToDate( buildFile, objectFileName, compileCommandHash ) )
  			    {
-                    // we only want to use the object file if it's newer than the source file
 				    buildFile = objectFileName;
 			    }
             }
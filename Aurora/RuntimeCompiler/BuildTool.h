@@ -20,6 +20,7 @@
 #include <vector>
 #include <string>
 #include "Compiler.h"
+#include "ObjectCache.h"
 
 #include "FileSystemUtils.h"
 
@@ -59,14 +60,31 @@ public:
 		return m_Compiler.GetIsComplete();
 	}
 
+	bool WaitForComplete( unsigned int maxMilliseconds_ )
+	{
+		return m_Compiler.WaitForComplete( maxMilliseconds_ );
+	}
+
+	const CompileTimings& GetCompileTimings() const
+	{
+		return m_Compiler.GetCompileTimings();
+	}
+
     void SetFastCompileMode( bool bFast )
     {
         m_Compiler.SetFastCompileMode( bFast );
     }
+
+    // see ObjectCache::SetCache, a maxSize_ of 0 disables the cache
+    void SetObjectCache( const FileSystemUtils::Path& directory_, uint64_t maxSize_ )
+    {
+        m_ObjectCache.SetCache( directory_, maxSize_ );
+    }
     
 
 private:
 	Compiler                    m_Compiler;
+	ObjectCache                 m_ObjectCache;
 	ICompilerLogger*            m_pLogger;
 };
 
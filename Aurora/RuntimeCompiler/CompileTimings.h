@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+inline TimePoint GetTimeNow()
+{
+	return std::chrono::steady_clock::now();
+}
+
+inline double GetSecondsSince( TimePoint start_ )
+{
+	return std::chrono::duration<double>( GetTimeNow() - start_ ).count();
+}
+
+// Wall clock timings in seconds of a compile, see Compiler::GetCompileTimings.
+// Completion is detected when the compiler is polled, so times include up to one poll interval.
+struct CompileTimings
+{
+	struct FileTiming
+	{
+		std::string	file;
+		double		seconds;
+	};
+
+	CompileTimings()
+	{
+		Clear();
+	}
+
+	void Clear()
+	{
+		totalSeconds = 0.0;
+		linkSeconds = 0.0;
+		files.clear();
+	}
+
+	double					totalSeconds;	// RunCompile until complete
+	double					linkSeconds;	// Posix only
+	std::vector<FileTiming>	files;			// Posix only, each precompiled header, preprocess and compile process
+};
@@ -22,8 +22,10 @@
 
 #include "FileSystemUtils.h"
 #include "CompileOptions.h"
+#include "CompileTimings.h"
 
 class PlatformCompilerImplData;
+class ObjectCache;
 struct ICompilerLogger;
 
 struct CompilerOptions
@@ -36,6 +38,8 @@ struct CompilerOptions
 	FileSystemUtils::Path				baseIntermediatePath;
 	FileSystemUtils::Path				intermediatePath;
 	FileSystemUtils::Path				compilerLocation;
+	unsigned int						maxParallelCompiles;	// Posix only, number of concurrent compile processes. 0 uses hardware concurrency.
+	FileSystemUtils::Path				precompiledHeader;		// Posix only, if set precompiled into intermediatePath and included in all files.
 };
 
 class Compiler
@@ -49,6 +53,8 @@ public:
     // however this can result in Zombie processes and also prevent handles such as sockets from being closed.
     // This function is safe to call at any time, but will only have an effect on Win32 compiles from the second
     // compile on after the call (as the first must launch the process and set the VS environment).
+    // On Posix a pool of worker shells is started with posix_spawn and kept between compiles, so compiles
+    // do not need to fork the application process or start a new shell.
     //
     // Defaults to m_bFastCompileMode = false
     void SetFastCompileMode( bool bFast )
@@ -62,7 +68,25 @@ public:
         }
     }
 
+    // Object cache to use for compiles, currently only supported on Posix. The cache is owned by the caller.
+    void SetObjectCache( ObjectCache* pObjectCache_ )
+    {
+        m_pObjectCache = pObjectCache_;
+    }
+
+    // Timings of the last compile, valid once GetIsComplete() returns true
+    const CompileTimings& GetCompileTimings() const;
+
     std::string GetObjectFileExtension() const;
+
+    // Returns the path of the object file sourceFile_ is compiled to in the intermediate directory
+    FileSystemUtils::Path GetObjectFilePath( const FileSystemUtils::Path& sourceFile_, const CompilerOptions& compilerOptions_ ) const;
+
+    // Returns a hash of the command line used to compile each source file to an object file, excluding
+    // the file names. Compilers which write a DependencyRecord next to each object file return a non
+    // zero value, which BuildTool checks against the record. Returns 0 if no records are written.
+    uint64_t    GetCompileCommandHash( const CompilerOptions& compilerOptions_ ) const;
+
 	void RunCompile( const std::vector<FileSystemUtils::Path>&	filesToCompile_,
                      const CompilerOptions&						compilerOptions_,
 					 const std::vector<FileSystemUtils::Path>&			linkLibraryList_,
@@ -70,7 +94,12 @@ public:
 
 
 	bool GetIsComplete() const;
+
+    // Blocks until the compile is complete or maxMilliseconds_ have passed, returning GetIsComplete().
+    // On Posix this waits on the output pipes of the running processes rather than sleeping for a fixed time.
+    bool WaitForComplete( unsigned int maxMilliseconds_ ) const;
 private:
 	PlatformCompilerImplData* m_pImplData;
     bool                      m_bFastCompileMode;
+    ObjectCache*              m_pObjectCache;
 };
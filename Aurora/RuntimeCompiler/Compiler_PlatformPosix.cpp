@@ -17,9 +17,8 @@
 
 //
 // Notes:
-//   - We use a single intermediate directory for compiled .obj files, which means
-//     we don't support compiling multiple files with the same name. Could fix this
-//     with either mangling names to include paths,  or recreating folder structure
+//   - We use a single intermediate directory for compiled .o files, so object file
+//     names include a hash of the source path to support multiple files with the same name
 //
 //
 
@@ -33,14 +32,100 @@
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <thread>
+#include <deque>
 
 #include "assert.h"
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <poll.h>
 
 #include "ICompilerLogger.h"
+#include "DependencyRecord.h"
+#include "ObjectCache.h"
 
 using namespace std;
-//const char	c_CompletionToken[] = "_COMPLETION_TOKEN_" ;
+const char	c_CompletionToken[] = "_COMPLETION_TOKEN_" ;
+
+extern char** environ;
+
+enum CompilerProcessType
+{
+    COMPILERPROCESS_PRECOMPILED_HEADER,
+    COMPILERPROCESS_PREPROCESS,
+    COMPILERPROCESS_COMPILE,
+    COMPILERPROCESS_LINK,
+};
+
+// A single child process running the precompiled header build, the preprocess or compile of one
+// translation unit, or the final link. In fast compile mode this is a job run by a CompilerWorker,
+// using the worker's pipes.
+struct CompilerProcess
+{
+	CompilerProcess( CompilerProcessType type_, int commandIndex_ = -1 )
+		: m_PID( 0 )
+        , m_Type( type_ )
+        , m_CommandIndex( commandIndex_ )
+        , m_Worker( -1 )
+        , m_bWorkerJobComplete( false )
+        , m_WorkerJobExitCode( 0 )
+	{
+        m_PipeStdOut[0] = 0;
+        m_PipeStdOut[1] = 1;
+        m_PipeStdErr[0] = 0;
+        m_PipeStdErr[1] = 1;
+	}
+
+    pid_t                   m_PID;
+    int                     m_PipeStdOut[2];
+    int                     m_PipeStdErr[2];
+    std::string             m_StdOutBuffer;     // output read but not yet logged as it is not a complete line
+    std::string             m_StdErrBuffer;
+    CompilerProcessType     m_Type;
+    int                     m_CommandIndex; // index into m_CompileCommands for preprocess and compile processes
+    TimePoint               m_StartTime;
+    int                     m_Worker;       // index into m_Workers if run by a worker, otherwise -1
+    bool                    m_bWorkerJobComplete;
+    int                     m_WorkerJobExitCode;
+};
+
+// Fast compile mode - a long lived shell started with posix_spawn, which runs commands written to its
+// stdin and reports completion with c_CompletionToken on stdout. This avoids a fork of the (potentially
+// large) application process and a shell startup for every compile.
+struct CompilerWorker
+{
+    CompilerWorker()
+        : m_PID( 0 )
+        , m_PipeStdIn( -1 )
+        , m_PipeStdOut( -1 )
+        , m_PipeStdErr( -1 )
+        , m_bBusy( false )
+    {
+    }
+
+    pid_t                   m_PID;
+    int                     m_PipeStdIn;    // write end
+    int                     m_PipeStdOut;   // read end
+    int                     m_PipeStdErr;   // read end
+    bool                    m_bBusy;
+};
+
+struct CompileCommand
+{
+    CompileCommand()
+        : m_CacheKey( 0 )
+    {
+    }
+
+    std::string             m_Command;
+    std::string             m_PreprocessCommand;    // only used when the object cache is enabled
+    FileSystemUtils::Path   m_SourceFile;
+    FileSystemUtils::Path   m_ObjectFile;
+    FileSystemUtils::Path   m_PreprocessedFile;
+    uint64_t                m_CacheKey;             // set after preprocessing on a cache miss
+};
 
 class PlatformCompilerImplData
 {
@@ -48,23 +133,692 @@ public:
 	PlatformCompilerImplData()
 		: m_bCompileIsComplete( false )
         , m_pLogger( 0 )
-        , m_ChildForCompilationPID( 0 )
+        , m_bLinkStarted( false )
+        , m_bCompileFailed( false )
+        , m_MaxProcesses( 1 )
+        , m_CompileCommandHash( 0 )
+        , m_pObjectCache( 0 )
+        , m_CacheKeySeed( 0 )
+        , m_NumCacheHitsAtStart( 0 )
+        , m_NumCacheMissesAtStart( 0 )
+        , m_bBuildingPrecompiledHeader( false )
+        , m_bUseWorkers( false )
 	{
-        m_PipeStdOut[0] = 0;
-        m_PipeStdOut[1] = 1;
-        m_PipeStdErr[0] = 0;
-        m_PipeStdErr[1] = 1;
 	}
 
-	volatile bool		m_bCompileIsComplete;
-	ICompilerLogger*	m_pLogger;
-    pid_t               m_ChildForCompilationPID;
-    int                 m_PipeStdOut[2];
-    int                 m_PipeStdErr[2];
+    ~PlatformCompilerImplData()
+    {
+        StopWorkers();
+    }
+
+    bool StartProcess( CompilerProcess process_ );
+    bool StartWorker( CompilerWorker& worker_ );
+    bool StartWorkerJob( CompilerProcess& process_, const std::string& command_ );
+    void CloseWorker( CompilerWorker& worker_ );
+    void StopWorkers();
+    void ReadPipe( CompilerProcess& process_, bool bError_, bool bFinal_ );
+    void ReadOutput( CompilerProcess& process_ );
+    void LogOutputAndClose( CompilerProcess& process_ );
+    bool ReadDependencies( const FileSystemUtils::Path& targetFile_, DependencyRecord& record_ );
+    void WriteDependencyRecord( const FileSystemUtils::Path& objectFile_ );
+    void OnPrecompiledHeaderComplete();
+    void OnPreprocessComplete( int commandIndex_ );
+    void RecordTiming( const CompilerProcess& process_ );
+    void SetComplete();
+    void UpdateProcesses();
+
+	volatile bool		        m_bCompileIsComplete;
+	ICompilerLogger*	        m_pLogger;
+
+    // Each translation unit is compiled by its own process (up to m_MaxProcesses at once),
+    // then a single link process creates the module once all compiles have succeeded.
+    // With the object cache enabled each translation unit is first preprocessed to find its
+    // cache key, and only compiled on a cache miss.
+    std::vector<CompileCommand>     m_CompileCommands;
+    std::deque<CompilerProcess>     m_PendingProcesses;
+    std::string                     m_LinkCommand;
+    bool                            m_bLinkStarted;
+    bool                            m_bCompileFailed;
+    unsigned int                    m_MaxProcesses;
+    std::vector<CompilerProcess>    m_Processes;
+    uint64_t                        m_CompileCommandHash;
+
+    ObjectCache*                    m_pObjectCache;
+    uint64_t                        m_CacheKeySeed;
+    unsigned int                    m_NumCacheHitsAtStart;
+    unsigned int                    m_NumCacheMissesAtStart;
+
+    // The precompiled header is built before any other process is started, and its
+    // dependencies are added to the dependency record of every object file.
+    std::string                         m_PrecompiledHeaderCommand;
+    FileSystemUtils::Path               m_PrecompiledHeaderFile;
+    std::vector<FileSystemUtils::Path>  m_PrecompiledHeaderDependencies;
+    bool                                m_bBuildingPrecompiledHeader;
+
+    CompileTimings                  m_CompileTimings;
+    TimePoint                       m_CompileStartTime;
+
+    bool                            m_bUseWorkers;  // set from Compiler::SetFastCompileMode
+    std::vector<CompilerWorker>     m_Workers;      // persist between compiles whilst in fast compile mode
 };
 
+// flags common to both compile and link
+static std::string GetCompileFlags( const CompilerOptions& compilerOptions_ )
+{
+    std::string compilerLocation = compilerOptions_.compilerLocation.m_string;
+    if (compilerLocation.size()==0){
+#ifdef __clang__
+        compilerLocation = "clang++ ";
+#else // default to g++
+        compilerLocation = "g++ ";
+#endif //__clang__
+    }
+
+	std::string flagsString = compilerLocation + " " + "-g -fPIC -fvisibility=hidden ";
+
+#ifndef __LP64__
+	flagsString += "-m32 ";
+#endif
+
+	RCppOptimizationLevel optimizationLevel = GetActualOptimizationLevel( compilerOptions_.optimizationLevel );
+	switch( optimizationLevel )
+	{
+	case RCCPPOPTIMIZATIONLEVEL_DEFAULT:
+		assert(false);
+	case RCCPPOPTIMIZATIONLEVEL_DEBUG:
+		flagsString += "-O0 ";
+		break;
+	case RCCPPOPTIMIZATIONLEVEL_PERF:
+		flagsString += "-Os ";
+		break;
+	case RCCPPOPTIMIZATIONLEVEL_NOT_SET:;
+	case RCCPPOPTIMIZATIONLEVEL_SIZE:;
+	}
+
+    // defines
+#if RCCPP_ALLOCATOR_INTERFACE
+    flagsString += "-DRCCPP_ALLOCATOR_INTERFACE=1 ";
+#endif
+
+	if( compilerOptions_.compileOptions.size() )
+	{
+		flagsString += compilerOptions_.compileOptions;
+		flagsString += " ";
+	}
+	return flagsString;
+}
+
+static std::string GetIncludeFlags( const CompilerOptions& compilerOptions_ )
+{
+    std::string includeString;
+    for( size_t i = 0; i < compilerOptions_.includeDirList.size(); ++i )
+	{
+        includeString += "-I\"" + compilerOptions_.includeDirList[i].m_string + "\" ";
+    }
+	return includeString;
+}
+
+bool PlatformCompilerImplData::StartProcess( CompilerProcess process )
+{
+    std::string command_;
+    switch( process.m_Type )
+    {
+    case COMPILERPROCESS_PRECOMPILED_HEADER:
+        command_ = m_PrecompiledHeaderCommand;
+        break;
+    case COMPILERPROCESS_PREPROCESS:
+        command_ = m_CompileCommands[ process.m_CommandIndex ].m_PreprocessCommand;
+        break;
+    case COMPILERPROCESS_COMPILE:
+        command_ = m_CompileCommands[ process.m_CommandIndex ].m_Command;
+        break;
+    case COMPILERPROCESS_LINK:
+        command_ = m_LinkCommand;
+        break;
+    }
+
+    process.m_StartTime = GetTimeNow();
+    if( m_bUseWorkers )
+    {
+        return StartWorkerJob( process, command_ );
+    }
+
+    //create pipes
+    if ( pipe( process.m_PipeStdOut ) != 0 )
+    {
+        if( m_pLogger )
+        {
+            m_pLogger->LogError( "Error in Compiler::RunCompile, cannot create pipe - perhaps insufficient memory?\n");
+        }
+        return false;
+    }
+    //create pipes
+    if ( pipe( process.m_PipeStdErr ) != 0 )
+    {
+        close( process.m_PipeStdOut[0] );
+        close( process.m_PipeStdOut[1] );
+        if( m_pLogger )
+        {
+            m_pLogger->LogError( "Error in Compiler::RunCompile, cannot create pipe - perhaps insufficient memory?\n");
+        }
+        return false;
+    }
+
+    std::cout << command_ << std::endl << std::endl;
+
+    pid_t retPID;
+    switch( retPID = fork() )
+    {
+        case -1: // error, no fork
+            close( process.m_PipeStdOut[0] );
+            close( process.m_PipeStdOut[1] );
+            close( process.m_PipeStdErr[0] );
+            close( process.m_PipeStdErr[1] );
+            if( m_pLogger )
+            {
+                m_pLogger->LogError( "Error in Compiler::RunCompile, cannot fork() process - perhaps insufficient memory?\n");
+            }
+            return false;
+        case 0: // child process - carries on below.
+            break;
+        default: // current process - returns to allow application to run whilst compiling
+            close( process.m_PipeStdOut[1] );
+            process.m_PipeStdOut[1] = 0;
+            close( process.m_PipeStdErr[1] );
+            process.m_PipeStdErr[1] = 0;
+            // ensure later compile processes do not inherit our read ends, and that we can
+            // read output as it arrives without blocking
+            fcntl( process.m_PipeStdOut[0], F_SETFD, FD_CLOEXEC );
+            fcntl( process.m_PipeStdErr[0], F_SETFD, FD_CLOEXEC );
+            fcntl( process.m_PipeStdOut[0], F_SETFL, fcntl( process.m_PipeStdOut[0], F_GETFL ) | O_NONBLOCK );
+            fcntl( process.m_PipeStdErr[0], F_SETFL, fcntl( process.m_PipeStdErr[0], F_GETFL ) | O_NONBLOCK );
+            process.m_PID = retPID;
+            m_Processes.push_back( process );
+            return true;
+    }
+
+    //duplicate the pipe to stdout, so output goes to pipe
+    dup2( process.m_PipeStdErr[1], STDERR_FILENO );
+    dup2( process.m_PipeStdOut[1], STDOUT_FILENO );
+    close( process.m_PipeStdOut[0] );
+    close( process.m_PipeStdErr[0] );
+
+    execl("/bin/sh", "sh", "-c", command_.c_str(), (const char*)NULL);
+    _exit( 1 ); // only get here if execl failed
+}
+
+// Starts a worker shell reading commands from a pipe on its stdin
+bool PlatformCompilerImplData::StartWorker( CompilerWorker& worker_ )
+{
+    int pipeStdIn[2];
+    int pipeStdOut[2];
+    int pipeStdErr[2];
+    if( pipe( pipeStdIn ) != 0 )
+    {
+        return false;
+    }
+    if( pipe( pipeStdOut ) != 0 )
+    {
+        close( pipeStdIn[0] );
+        close( pipeStdIn[1] );
+        return false;
+    }
+    if( pipe( pipeStdErr ) != 0 )
+    {
+        close( pipeStdIn[0] );
+        close( pipeStdIn[1] );
+        close( pipeStdOut[0] );
+        close( pipeStdOut[1] );
+        return false;
+    }
+
+    // our ends of the pipes must not be inherited by other workers or compile processes
+    fcntl( pipeStdIn[1], F_SETFD, FD_CLOEXEC );
+    fcntl( pipeStdOut[0], F_SETFD, FD_CLOEXEC );
+    fcntl( pipeStdErr[0], F_SETFD, FD_CLOEXEC );
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init( &fileActions );
+    posix_spawn_file_actions_adddup2( &fileActions, pipeStdIn[0], STDIN_FILENO );
+    posix_spawn_file_actions_adddup2( &fileActions, pipeStdOut[1], STDOUT_FILENO );
+    posix_spawn_file_actions_adddup2( &fileActions, pipeStdErr[1], STDERR_FILENO );
+    posix_spawn_file_actions_addclose( &fileActions, pipeStdIn[0] );
+    posix_spawn_file_actions_addclose( &fileActions, pipeStdOut[1] );
+    posix_spawn_file_actions_addclose( &fileActions, pipeStdErr[1] );
+
+    char argShell[] = "sh";
+    char argStdIn[] = "-s";
+    char* argv[] = { argShell, argStdIn, NULL };
+    pid_t pid = 0;
+    int ret = posix_spawn( &pid, "/bin/sh", &fileActions, NULL, argv, environ );
+    posix_spawn_file_actions_destroy( &fileActions );
+
+    close( pipeStdIn[0] );
+    close( pipeStdOut[1] );
+    close( pipeStdErr[1] );
+    if( ret != 0 )
+    {
+        close( pipeStdIn[1] );
+        close( pipeStdOut[0] );
+        close( pipeStdErr[0] );
+        return false;
+    }
+
+    fcntl( pipeStdOut[0], F_SETFL, fcntl( pipeStdOut[0], F_GETFL ) | O_NONBLOCK );
+    fcntl( pipeStdErr[0], F_SETFL, fcntl( pipeStdErr[0], F_GETFL ) | O_NONBLOCK );
+    worker_.m_PID = pid;
+    worker_.m_PipeStdIn = pipeStdIn[1];
+    worker_.m_PipeStdOut = pipeStdOut[0];
+    worker_.m_PipeStdErr = pipeStdErr[0];
+    worker_.m_bBusy = false;
+    return true;
+}
+
+bool PlatformCompilerImplData::StartWorkerJob( CompilerProcess& process_, const std::string& command_ )
+{
+    // find an idle worker which is still running, starting a new one if needed
+    int workerIndex = -1;
+    for( size_t i = 0; i < m_Workers.size() && workerIndex < 0; ++i )
+    {
+        CompilerWorker& worker = m_Workers[i];
+        if( worker.m_bBusy )
+        {
+            continue;
+        }
+        int procStatus = 0;
+        if( worker.m_PID && waitpid( worker.m_PID, &procStatus, WNOHANG ) == 0 )
+        {
+            workerIndex = (int)i;
+        }
+        else
+        {
+            // worker exited, replace with a new one
+            CloseWorker( worker );
+            if( StartWorker( worker ) )
+            {
+                workerIndex = (int)i;
+            }
+        }
+    }
+    if( workerIndex < 0 )
+    {
+        CompilerWorker worker;
+        if( StartWorker( worker ) )
+        {
+            workerIndex = (int)m_Workers.size();
+            m_Workers.push_back( worker );
+        }
+    }
+    if( workerIndex < 0 )
+    {
+        if( m_pLogger )
+        {
+            m_pLogger->LogError( "Error in Compiler::RunCompile, cannot start compile worker process\n");
+        }
+        return false;
+    }
+
+    CompilerWorker& worker = m_Workers[ workerIndex ];
+    std::cout << command_ << std::endl << std::endl;
+    // the token is preceded by a newline so it starts a line even if the output of the command did not
+    // end with one, ReadPipe skips the resulting empty line
+    std::string job = command_ + " < /dev/null\nprintf '\\n%s %d\\n' \"" + c_CompletionToken + "\" $?\n";
+    if( write( worker.m_PipeStdIn, job.c_str(), job.size() ) != (ssize_t)job.size() )
+    {
+        if( m_pLogger )
+        {
+            m_pLogger->LogError( "Error in Compiler::RunCompile, cannot send command to compile worker process\n");
+        }
+        return false;
+    }
+
+    worker.m_bBusy = true;
+    process_.m_PID = worker.m_PID;
+    process_.m_Worker = workerIndex;
+    process_.m_PipeStdOut[0] = worker.m_PipeStdOut;
+    process_.m_PipeStdErr[0] = worker.m_PipeStdErr;
+    m_Processes.push_back( process_ );
+    return true;
+}
+
+// Closing stdin causes the shell to exit once it has finished any current command
+void PlatformCompilerImplData::CloseWorker( CompilerWorker& worker_ )
+{
+    if( worker_.m_PipeStdIn >= 0 )
+    {
+        close( worker_.m_PipeStdIn );
+        close( worker_.m_PipeStdOut );
+        close( worker_.m_PipeStdErr );
+    }
+    worker_.m_PipeStdIn = worker_.m_PipeStdOut = worker_.m_PipeStdErr = -1;
+    if( worker_.m_PID )
+    {
+        int procStatus = 0;
+        waitpid( worker_.m_PID, &procStatus, 0 );
+    }
+    worker_.m_PID = 0;
+}
+
+void PlatformCompilerImplData::StopWorkers()
+{
+    for( size_t i = 0; i < m_Workers.size(); ++i )
+    {
+        CloseWorker( m_Workers[i] );
+    }
+    m_Workers.clear();
+}
+
+// Reads all currently available output from a non-blocking pipe and logs any complete lines.
+// If bFinal_ the process has exited, so any partial line left is logged too.
+// Worker job completion is detected from the completion token on stdout.
+void PlatformCompilerImplData::ReadPipe( CompilerProcess& process_, bool bError_, bool bFinal_ )
+{
+    int pipe_ = bError_ ? process_.m_PipeStdErr[0] : process_.m_PipeStdOut[0];
+    std::string& buffer_ = bError_ ? process_.m_StdErrBuffer : process_.m_StdOutBuffer;
+    char readBuffer[4096];
+    ssize_t numread = 0;
+    while( ( numread = read( pipe_, readBuffer, sizeof( readBuffer ) ) ) > 0 )
+    {
+        buffer_.append( readBuffer, numread );
+    }
+
+    // log line by line, as loggers may have a limited message size
+    size_t lineStart = 0;
+    while( lineStart < buffer_.size() )
+    {
+        size_t lineEnd = buffer_.find( '\n', lineStart );
+        if( std::string::npos == lineEnd )
+        {
+            if( !bFinal_ )
+            {
+                break;
+            }
+            lineEnd = buffer_.size() - 1;
+        }
+        std::string line = buffer_.substr( lineStart, lineEnd + 1 - lineStart );
+        if( !bError_ && process_.m_Worker >= 0 && line == "\n" )
+        {
+            // an empty line may be the one written before the completion token, so wait for the next line
+            size_t nextLineEnd = buffer_.find( '\n', lineEnd + 1 );
+            if( std::string::npos == nextLineEnd && !bFinal_ )
+            {
+                break;
+            }
+            if( 0 == buffer_.compare( lineEnd + 1, sizeof( c_CompletionToken ) - 1, c_CompletionToken ) )
+            {
+                lineStart = lineEnd + 1;
+                continue;
+            }
+        }
+        lineStart = lineEnd + 1;
+        if( !bError_ && process_.m_Worker >= 0 && 0 == line.compare( 0, sizeof( c_CompletionToken ) - 1, c_CompletionToken ) )
+        {
+            process_.m_bWorkerJobComplete = true;
+            process_.m_WorkerJobExitCode = atoi( line.c_str() + sizeof( c_CompletionToken ) - 1 );
+            break;
+        }
+        if( m_pLogger )
+        {
+            if( bError_ )
+            {
+                m_pLogger->LogError( "%s", line.c_str() );    //TODO: seperate warnings from errors.
+            }
+            else
+            {
+                m_pLogger->LogInfo( "%s", line.c_str() );
+            }
+        }
+    }
+    buffer_.erase( 0, lineStart );
+}
+
+// Drains output from a running process, so it never blocks on a full pipe
+void PlatformCompilerImplData::ReadOutput( CompilerProcess& process_ )
+{
+    ReadPipe( process_, false, false );
+    // once a worker job is complete all its stderr output has already been written to the pipe
+    ReadPipe( process_, true, process_.m_bWorkerJobComplete );
+}
+
+void PlatformCompilerImplData::LogOutputAndClose( CompilerProcess& process_ )
+{
+    // get remaining output and log
+    ReadPipe( process_, false, true );
+    ReadPipe( process_, true, true );
+    if( process_.m_Worker >= 0 )
+    {
+        // pipes are owned by the worker
+        m_Workers[ process_.m_Worker ].m_bBusy = false;
+        return;
+    }
+
+    // close the pipes as this process no longer needs them.
+    close( process_.m_PipeStdOut[0] );
+    process_.m_PipeStdOut[0] = 0;
+    close( process_.m_PipeStdErr[0] );
+    process_.m_PipeStdErr[0] = 0;
+}
+
+// Reads and removes the make format dependency file output by the compiler for targetFile_
+bool PlatformCompilerImplData::ReadDependencies( const FileSystemUtils::Path& targetFile_, DependencyRecord& record_ )
+{
+    FileSystemUtils::Path depFile = targetFile_;
+    depFile.ReplaceExtension( ".d" );
+    std::ifstream depStream( depFile.c_str(), std::ios::binary );
+    if( !depStream )
+    {
+        return false;
+    }
+    std::stringstream contents;
+    contents << depStream.rdbuf();
+    depStream.close();
+    depFile.Remove();
+
+    record_.compileCommandHash = m_CompileCommandHash;
+    record_.ParseMakeDependencies( contents.str() );
+    return true;
+}
+
+// Converts the make format dependency file output by the compiler into a DependencyRecord
+void PlatformCompilerImplData::WriteDependencyRecord( const FileSystemUtils::Path& objectFile_ )
+{
+    DependencyRecord record;
+    if( !ReadDependencies( objectFile_, record ) )
+    {
+        return;
+    }
+    record.dependencies.insert( record.dependencies.end(),
+                                m_PrecompiledHeaderDependencies.begin(), m_PrecompiledHeaderDependencies.end() );
+    if( !record.Save( DependencyRecord::GetRecordPath( objectFile_ ) ) && m_pLogger )
+    {
+        m_pLogger->LogWarning( "Could not write dependency record for %s\n", objectFile_.c_str() );
+    }
+}
+
+void PlatformCompilerImplData::OnPrecompiledHeaderComplete()
+{
+    DependencyRecord record;
+    if( ReadDependencies( m_PrecompiledHeaderFile, record ) )
+    {
+        m_PrecompiledHeaderDependencies = record.dependencies;
+        record.Save( DependencyRecord::GetRecordPath( m_PrecompiledHeaderFile ) );
+    }
+}
+
+// Looks up the preprocessed source in the object cache, queuing a compile on a miss
+void PlatformCompilerImplData::OnPreprocessComplete( int commandIndex_ )
+{
+    CompileCommand& compileCommand = m_CompileCommands[ commandIndex_ ];
+    std::ifstream preprocessedStream( compileCommand.m_PreprocessedFile.c_str(), std::ios::binary );
+    std::stringstream contents;
+    contents << preprocessedStream.rdbuf();
+    preprocessedStream.close();
+    compileCommand.m_PreprocessedFile.Remove();
+
+    std::string preprocessed = contents.str();
+    uint64_t key = HashData( preprocessed.c_str(), preprocessed.size(), m_CacheKeySeed );
+    if( preprocessed.size() && m_pObjectCache->Fetch( key, compileCommand.m_ObjectFile ) )
+    {
+        // preprocessing wrote the dependency file
+        WriteDependencyRecord( compileCommand.m_ObjectFile );
+        return;
+    }
+    compileCommand.m_CacheKey = key;
+    m_PendingProcesses.push_front( CompilerProcess( COMPILERPROCESS_COMPILE, commandIndex_ ) );
+}
+
+void PlatformCompilerImplData::RecordTiming( const CompilerProcess& process_ )
+{
+    double seconds = GetSecondsSince( process_.m_StartTime );
+    CompileTimings::FileTiming timing;
+    timing.seconds = seconds;
+    switch( process_.m_Type )
+    {
+    case COMPILERPROCESS_PRECOMPILED_HEADER:
+        timing.file = m_PrecompiledHeaderFile.m_string;
+        break;
+    case COMPILERPROCESS_PREPROCESS:
+        timing.file = m_CompileCommands[ process_.m_CommandIndex ].m_SourceFile.m_string + " (preprocess)";
+        break;
+    case COMPILERPROCESS_COMPILE:
+        timing.file = m_CompileCommands[ process_.m_CommandIndex ].m_SourceFile.m_string;
+        break;
+    case COMPILERPROCESS_LINK:
+        m_CompileTimings.linkSeconds = seconds;
+        return;
+    }
+    m_CompileTimings.files.push_back( timing );
+}
+
+void PlatformCompilerImplData::SetComplete()
+{
+    m_bCompileIsComplete = true;
+    m_CompileTimings.totalSeconds = GetSecondsSince( m_CompileStartTime );
+    if( m_pObjectCache && m_pObjectCache->GetIsEnabled() && m_pLogger )
+    {
+        m_pLogger->LogInfo( "[RuntimeCompiler] Object cache hits: %u, misses: %u (total hits: %u, misses: %u)\n",
+                            m_pObjectCache->GetNumHits() - m_NumCacheHitsAtStart,
+                            m_pObjectCache->GetNumMisses() - m_NumCacheMissesAtStart,
+                            m_pObjectCache->GetNumHits(), m_pObjectCache->GetNumMisses() );
+    }
+}
+
+void PlatformCompilerImplData::UpdateProcesses()
+{
+    // check for whether processes are closed
+    for( size_t i = 0; i < m_Processes.size(); )
+    {
+        ReadOutput( m_Processes[i] );
+        bool bComplete = false;
+        bool bSucceeded = false;
+        if( m_Processes[i].m_bWorkerJobComplete )
+        {
+            bComplete = true;
+            bSucceeded = 0 == m_Processes[i].m_WorkerJobExitCode;
+        }
+        else
+        {
+            // for worker jobs this checks the worker has not exited, which fails the job
+            int procStatus = 0;
+            pid_t ret = waitpid( m_Processes[i].m_PID, &procStatus, WNOHANG );
+            bool bExited = ret > 0 && ( WIFEXITED(procStatus) || WIFSIGNALED(procStatus) );
+            bComplete = bExited || ret < 0;
+            bSucceeded = bExited && m_Processes[i].m_Worker < 0 && WIFEXITED(procStatus) && WEXITSTATUS(procStatus) == 0;
+            if( bComplete && m_Processes[i].m_Worker >= 0 )
+            {
+                m_Workers[ m_Processes[i].m_Worker ].m_PID = 0; // restarted on next use
+            }
+        }
+        if( bComplete )
+        {
+            LogOutputAndClose( m_Processes[i] );
+            int commandIndex = m_Processes[i].m_CommandIndex;
+            RecordTiming( m_Processes[i] );
+            if( COMPILERPROCESS_PRECOMPILED_HEADER == m_Processes[i].m_Type )
+            {
+                m_bBuildingPrecompiledHeader = false;
+            }
+            if( !bSucceeded )
+            {
+                m_bCompileFailed = true;
+                if( COMPILERPROCESS_PRECOMPILED_HEADER == m_Processes[i].m_Type )
+                {
+                    // ensure a partial precompiled header is not used
+                    m_PrecompiledHeaderFile.Remove();
+                }
+            }
+            else
+            {
+                switch( m_Processes[i].m_Type )
+                {
+                case COMPILERPROCESS_PRECOMPILED_HEADER:
+                    OnPrecompiledHeaderComplete();
+                    break;
+                case COMPILERPROCESS_PREPROCESS:
+                    OnPreprocessComplete( commandIndex );
+                    break;
+                case COMPILERPROCESS_COMPILE:
+                {
+                    const CompileCommand& compileCommand = m_CompileCommands[ commandIndex ];
+                    WriteDependencyRecord( compileCommand.m_ObjectFile );
+                    if( compileCommand.m_CacheKey )
+                    {
+                        m_pObjectCache->Store( compileCommand.m_CacheKey, compileCommand.m_ObjectFile );
+                    }
+                    break;
+                }
+                case COMPILERPROCESS_LINK:
+                    break;
+                }
+            }
+            m_Processes.erase( m_Processes.begin() + i );
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // no new compiles are started once one fails, but we let running ones finish.
+    // Nothing else is started until the precompiled header is built.
+    while( !m_bCompileFailed
+           && !m_bBuildingPrecompiledHeader
+           && m_PendingProcesses.size()
+           && m_Processes.size() < m_MaxProcesses )
+    {
+        CompilerProcess process = m_PendingProcesses.front();
+        m_PendingProcesses.pop_front();
+        if( !StartProcess( process ) )
+        {
+            m_bCompileFailed = true;
+        }
+        else if( COMPILERPROCESS_PRECOMPILED_HEADER == process.m_Type )
+        {
+            m_bBuildingPrecompiledHeader = true;
+        }
+    }
+
+    if( m_Processes.empty() && ( m_bCompileFailed || m_PendingProcesses.empty() ) )
+    {
+        if( !m_bCompileFailed && !m_bLinkStarted )
+        {
+            m_bLinkStarted = true;
+            if( !StartProcess( CompilerProcess( COMPILERPROCESS_LINK ) ) )
+            {
+                SetComplete();
+            }
+        }
+        else
+        {
+            SetComplete();
+        }
+    }
+}
+
 Compiler::Compiler() 
 	: m_pImplData( 0 )
+    , m_bFastCompileMode( false )
+    , m_pObjectCache( 0 )
 {
 }
 
@@ -78,46 +832,82 @@ std::string Compiler::GetObjectFileExtension() const
 	return ".o";
 }
 
+FileSystemUtils::Path Compiler::GetObjectFilePath( const FileSystemUtils::Path& sourceFile_, const CompilerOptions& compilerOptions_ ) const
+{
+    // <intermediate>/<name>_<path hash>.o, so sources with the same name in different directories don't collide
+    char pathHash[24];
+    snprintf( pathHash, sizeof( pathHash ), "_%016" PRIx64, HashString( sourceFile_.m_string ) );
+    FileSystemUtils::Path objectFile = compilerOptions_.intermediatePath / sourceFile_.Filename();
+    objectFile.ReplaceExtension( pathHash + GetObjectFileExtension() );
+    return objectFile;
+}
+
+uint64_t Compiler::GetCompileCommandHash( const CompilerOptions& compilerOptions_ ) const
+{
+    uint64_t hash = HashString( GetCompileFlags( compilerOptions_ ) + GetIncludeFlags( compilerOptions_ )
+                                + compilerOptions_.precompiledHeader.m_string );
+    return hash ? hash : 1; // 0 is reserved for no dependency records
+}
+
+const CompileTimings& Compiler::GetCompileTimings() const
+{
+    return m_pImplData->m_CompileTimings;
+}
+
 bool Compiler::GetIsComplete() const
 {
-    if( !m_pImplData->m_bCompileIsComplete && m_pImplData->m_ChildForCompilationPID )
+    if( !m_pImplData->m_bCompileIsComplete && ( m_pImplData->m_Processes.size() || m_pImplData->m_bLinkStarted ) )
+    {
+        m_pImplData->UpdateProcesses();
+    }
+    if( m_pImplData->m_bCompileIsComplete && !m_bFastCompileMode )
+    {
+        m_pImplData->StopWorkers();
+    }
+	return m_pImplData->m_bCompileIsComplete;
+}
+
+bool Compiler::WaitForComplete( unsigned int maxMilliseconds_ ) const
+{
+    TimePoint startTime = GetTimeNow();
+    std::vector<pollfd> pollFds;
+    while( !GetIsComplete() )
     {
-        
-        // check for whether process is closed
-        int procStatus;
-        pid_t ret = waitpid( m_pImplData->m_ChildForCompilationPID, &procStatus, WNOHANG);
-        if( ret && ( WIFEXITED(procStatus) || WIFSIGNALED(procStatus) ) )
+        int remainingMilliseconds = (int)maxMilliseconds_ - (int)( GetSecondsSince( startTime ) * 1000.0 );
+        if( remainingMilliseconds <= 0 )
         {
-            m_pImplData->m_bCompileIsComplete = true;
-            m_pImplData->m_ChildForCompilationPID = 0;
- 
-            // get output and log
-            if( m_pImplData->m_pLogger )
+            return false;
+        }
+
+        // output or the pipes closing on exit wakes us, worker jobs write their completion token to stdout
+        pollFds.clear();
+        for( size_t i = 0; i < m_pImplData->m_Processes.size(); ++i )
+        {
+            const CompilerProcess& process = m_pImplData->m_Processes[i];
+            pollfd stdOut = { process.m_PipeStdOut[0], POLLIN, 0 };
+            pollfd stdErr = { process.m_PipeStdErr[0], POLLIN, 0 };
+            pollFds.push_back( stdOut );
+            pollFds.push_back( stdErr );
+        }
+        int ret = poll( pollFds.empty() ? NULL : &pollFds[0], pollFds.size(), remainingMilliseconds );
+        if( ret > 0 )
+        {
+            bool bOutputOnly = true;
+            for( size_t i = 0; i < pollFds.size(); ++i )
             {
-                const size_t buffSize = 256 * 80; //should allow for a few lines...
-                char buffer[buffSize];
-                ssize_t numread = 0;
-                while( ( numread = read( m_pImplData->m_PipeStdOut[0], buffer, buffSize-1 ) ) > 0 )
+                if( pollFds[i].revents & ~POLLIN )
                 {
-                    buffer[numread] = 0;
-                    m_pImplData->m_pLogger->LogInfo( buffer );
-                }
-                
-                while( ( numread = read( m_pImplData->m_PipeStdErr[0], buffer, buffSize-1 ) )> 0 )
-                {
-                    buffer[numread] = 0;
-                    m_pImplData->m_pLogger->LogError( buffer );    //TODO: seperate warnings from errors.
+                    bOutputOnly = false;
                 }
             }
-
-            // close the pipes as this process no longer needs them.
-            close( m_pImplData->m_PipeStdOut[0] );
-            m_pImplData->m_PipeStdOut[0] = 0;
-            close( m_pImplData->m_PipeStdErr[0] );
-            m_pImplData->m_PipeStdErr[0] = 0;
+            if( !bOutputOnly )
+            {
+                // a pipe closes just before its process can be reaped, so avoid spinning on it
+                usleep( 1000 );
+            }
         }
     }
-	return m_pImplData->m_bCompileIsComplete;
+    return true;
 }
 
 void Compiler::Initialise( ICompilerLogger * pLogger )
@@ -132,90 +922,45 @@ void Compiler::RunCompile( const std::vector<FileSystemUtils::Path>&	filesToComp
 			    const FileSystemUtils::Path&		moduleName_ )
 
 {
-    const std::vector<FileSystemUtils::Path>& includeDirList = compilerOptions_.includeDirList;
     const std::vector<FileSystemUtils::Path>& libraryDirList = compilerOptions_.libraryDirList;
-    const char* pCompileOptions =  compilerOptions_.compileOptions.c_str();
     const char* pLinkOptions = compilerOptions_.linkOptions.c_str();
 
-    std::string compilerLocation = compilerOptions_.compilerLocation.m_string;
-    if (compilerLocation.size()==0){
-#ifdef __clang__
-        compilerLocation = "clang++ ";
-#else // default to g++
-        compilerLocation = "g++ ";
-#endif //__clang__
-    }
-
     //NOTE: Currently doesn't check if a prior compile is ongoing or not, which could lead to memory leaks
 	m_pImplData->m_bCompileIsComplete = false;
-    
-    //create pipes
-    if ( pipe( m_pImplData->m_PipeStdOut ) != 0 )
-    {
-        if( m_pImplData->m_pLogger )
-        {
-            m_pImplData->m_pLogger->LogError( "Error in Compiler::RunCompile, cannot create pipe - perhaps insufficient memory?\n");
-        }
-        return;
-    }
-    //create pipes
-    if ( pipe( m_pImplData->m_PipeStdErr ) != 0 )
+    m_pImplData->m_CompileCommands.clear();
+    m_pImplData->m_PendingProcesses.clear();
+    m_pImplData->m_LinkCommand.clear();
+    m_pImplData->m_bLinkStarted = false;
+    m_pImplData->m_bCompileFailed = false;
+    m_pImplData->m_bUseWorkers = m_bFastCompileMode;
+    m_pImplData->m_CompileTimings.Clear();
+    m_pImplData->m_CompileStartTime = GetTimeNow();
+    m_pImplData->m_PrecompiledHeaderFile = FileSystemUtils::Path();
+    m_pImplData->m_PrecompiledHeaderDependencies.clear();
+    m_pImplData->m_bBuildingPrecompiledHeader = false;
+
+    m_pImplData->m_MaxProcesses = compilerOptions_.maxParallelCompiles;
+    if( 0 == m_pImplData->m_MaxProcesses )
     {
-        if( m_pImplData->m_pLogger )
+        m_pImplData->m_MaxProcesses = std::thread::hardware_concurrency();
+        if( 0 == m_pImplData->m_MaxProcesses )
         {
-            m_pImplData->m_pLogger->LogError( "Error in Compiler::RunCompile, cannot create pipe - perhaps insufficient memory?\n");
+            m_pImplData->m_MaxProcesses = 1;
         }
-        return;
     }
-    
-    pid_t retPID;
-    switch( retPID = fork() )
-    {
-        case -1: // error, no fork
-            if( m_pImplData->m_pLogger )
-            {
-                m_pImplData->m_pLogger->LogError( "Error in Compiler::RunCompile, cannot fork() process - perhaps insufficient memory?\n");
-            }
-            return;
-        case 0: // child process - carries on below.
-            break;
-        default: // current process - returns to allow application to run whilst compiling
-            close( m_pImplData->m_PipeStdOut[1] );
-            m_pImplData->m_PipeStdOut[1] = 0;
-            close( m_pImplData->m_PipeStdErr[1] );
-            m_pImplData->m_PipeStdErr[1] = 0;
-            m_pImplData->m_ChildForCompilationPID = retPID;
-           return;
-    }
-    
-    //duplicate the pipe to stdout, so output goes to pipe
-    dup2( m_pImplData->m_PipeStdErr[1], STDERR_FILENO );
-    dup2( m_pImplData->m_PipeStdOut[1], STDOUT_FILENO );
-    close( m_pImplData->m_PipeStdOut[0] );
-    m_pImplData->m_PipeStdOut[0] = 0;
-    close( m_pImplData->m_PipeStdErr[0] );
-    m_pImplData->m_PipeStdErr[0] = 0;
-
-	std::string compileString = compilerLocation + " " + "-g -fPIC -fvisibility=hidden -shared ";
 
-#ifndef __LP64__
-	compileString += "-m32 ";
-#endif
+	std::string flagsString = GetCompileFlags( compilerOptions_ );
+    m_pImplData->m_CompileCommandHash = GetCompileCommandHash( compilerOptions_ );
 
-	RCppOptimizationLevel optimizationLevel = GetActualOptimizationLevel( compilerOptions_.optimizationLevel );
-	switch( optimizationLevel )
-	{
-	case RCCPPOPTIMIZATIONLEVEL_DEFAULT:
-		assert(false);
-	case RCCPPOPTIMIZATIONLEVEL_DEBUG:
-		compileString += "-O0 ";
-		break;
-	case RCCPPOPTIMIZATIONLEVEL_PERF:
-		compileString += "-Os ";
-		break;
-	case RCCPPOPTIMIZATIONLEVEL_NOT_SET:;
-	case RCCPPOPTIMIZATIONLEVEL_SIZE:;
-	}
+    // object cache key is the hash of the preprocessed source, compile command line and link options
+    m_pImplData->m_pObjectCache = m_pObjectCache;
+    bool bUseObjectCache = m_pObjectCache && m_pObjectCache->GetIsEnabled();
+    if( bUseObjectCache )
+    {
+        m_pImplData->m_CacheKeySeed = HashString( compilerOptions_.linkOptions, m_pImplData->m_CompileCommandHash );
+        m_pImplData->m_NumCacheHitsAtStart = m_pObjectCache->GetNumHits();
+        m_pImplData->m_NumCacheMissesAtStart = m_pObjectCache->GetNumMisses();
+    }
     
 	// Check for intermediate directory, create it if required
 	// There are a lot more checks and robustness that could be added here
@@ -225,80 +970,134 @@ void Compiler::RunCompile( const std::vector<FileSystemUtils::Path>&	filesToComp
 		if( success && m_pImplData->m_pLogger ) { m_pImplData->m_pLogger->LogInfo("Created intermediate folder \"%s\"\n", compilerOptions_.intermediatePath.c_str()); }
 		else if( m_pImplData->m_pLogger ) { m_pImplData->m_pLogger->LogError("Error creating intermediate folder \"%s\"\n", compilerOptions_.intermediatePath.c_str()); }
 	}
+	bool bCompileToObjects = compilerOptions_.intermediatePath.Exists();
 
-	FileSystemUtils::Path	output = moduleName_;
-	bool bCopyOutput = false;
-	if( compilerOptions_.intermediatePath.Exists() )
-	{
-		// add save object files
-        compileString = "cd \"" + compilerOptions_.intermediatePath.m_string + "\"\n" + compileString + " --save-temps ";
-		output = compilerOptions_.intermediatePath / "a.out";
-		bCopyOutput = true;
-#ifndef __clang__
-		// By default, GCC adds a 'a-' (because our output is a.out) prefix to the intermediary files by default, making us not find the .o files later when recompiling.
-		compileString += "-dumpbase '' ";
-#endif
-
-	}
+    std::string includeString = GetIncludeFlags( compilerOptions_ );
 
-    // defines
-#if RCCPP_ALLOCATOR_INTERFACE
-    compileString += "-DRCCPP_ALLOCATOR_INTERFACE=1 ";
-#endif
+    // The precompiled header is built to <intermediate>/<header>.gch, and included in each file through
+    // <intermediate>/<header> so both GCC and Clang find it. Preprocessing for the object cache needs
+    // the original header, as the precompiled header is not used by -E.
+    std::string preprocessIncludeString = includeString;
+    bool bBuildPrecompiledHeader = false;
+    if( bCompileToObjects && compilerOptions_.precompiledHeader.m_string.size() )
+    {
+        const FileSystemUtils::Path& header = compilerOptions_.precompiledHeader;
+        FileSystemUtils::Path includeFile = compilerOptions_.intermediatePath / header.Filename();
+        m_pImplData->m_PrecompiledHeaderFile = includeFile.m_string + ".gch";
+        FileSystemUtils::Path depFile = m_pImplData->m_PrecompiledHeaderFile;
+        depFile.ReplaceExtension( ".d" );
 
-    // include directories
-    for( size_t i = 0; i < includeDirList.size(); ++i )
-	{
-        compileString += "-I\"" + includeDirList[i].m_string + "\" ";
+        DependencyRecord record;
+        bool bUpToDate = m_pImplData->m_PrecompiledHeaderFile.Exists()
+                         && record.Load( DependencyRecord::GetRecordPath( m_pImplData->m_PrecompiledHeaderFile ) )
+                         && record.compileCommandHash == m_pImplData->m_CompileCommandHash
+                         && record.GetAreDependenciesOlderThan( m_pImplData->m_PrecompiledHeaderFile.GetLastWriteTime() );
+        if( bUpToDate )
+        {
+            m_pImplData->m_PrecompiledHeaderDependencies = record.dependencies;
+        }
+        else
+        {
+            m_pImplData->m_PrecompiledHeaderCommand = flagsString + includeString
+                + "-x c++-header -MD -MF \"" + depFile.m_string + "\" "
+                + "\"" + header.m_string + "\" -o \"" + m_pImplData->m_PrecompiledHeaderFile.m_string + "\"";
+            bBuildPrecompiledHeader = true;
+        }
+        includeString += "-Winvalid-pch -include \"" + includeFile.m_string + "\" ";
+        preprocessIncludeString += "-include \"" + header.m_string + "\" ";
     }
-    
+
+	std::string linkString = flagsString + "-shared ";
+
     // library and framework directories
     for( size_t i = 0; i < libraryDirList.size(); ++i )
 	{
-        compileString += "-L\"" + libraryDirList[i].m_string + "\" ";
-        compileString += "-F\"" + libraryDirList[i].m_string + "\" ";
+        linkString += "-L\"" + libraryDirList[i].m_string + "\" ";
+        linkString += "-F\"" + libraryDirList[i].m_string + "\" ";
     }
-    
-	if( !bCopyOutput )
-	{
-	    // output file
-	    compileString += "-o " + output.m_string + " ";
-	}
 
-
-	if( pCompileOptions )
-	{
-		compileString += pCompileOptions;
-		compileString += " ";
-	}
 	if( pLinkOptions && strlen(pLinkOptions) )
 	{
-		compileString += "-Wl,";
-		compileString += pLinkOptions;
-		compileString += " ";
+		linkString += "-Wl,";
+		linkString += pLinkOptions;
+		linkString += " ";
 	}
-	
-    // files to compile
+
+	// files to compile - each source file gets its own compile process writing an object file to
+	// the intermediate directory, object files from prior compiles are passed straight to the link.
+	std::string objectFileExtension = GetObjectFileExtension();
+	std::vector<FileSystemUtils::Path> objectFiles;
+	std::vector<FileSystemUtils::Path> objectSourceFiles;
     for( size_t i = 0; i < filesToCompile_.size(); ++i )
     {
-        compileString += "\"" + filesToCompile_[i].m_string + "\" ";
+		const FileSystemUtils::Path& file = filesToCompile_[i];
+		if( !bCompileToObjects )
+		{
+			// no intermediate directory so compile and link in one step
+			linkString += includeString + "\"" + file.m_string + "\" ";
+			continue;
+		}
+
+		FileSystemUtils::Path objectFile = file;
+		if( file.Extension() != objectFileExtension )
+		{
+			objectFile = GetObjectFilePath( file, compilerOptions_ );
+		}
+		std::vector<FileSystemUtils::Path>::iterator itObject = find( objectFiles.begin(), objectFiles.end(), objectFile );
+		if( itObject != objectFiles.end() )
+		{
+			// a file listed twice is only built once, but two sources must never share an object
+			const FileSystemUtils::Path& otherFile = objectSourceFiles[ itObject - objectFiles.begin() ];
+			if( !( otherFile == file ) && m_pImplData->m_pLogger )
+			{
+				m_pImplData->m_pLogger->LogError( "Source files \"%s\" and \"%s\" both compile to object file \"%s\", skipping the second\n",
+					otherFile.c_str(), file.c_str(), objectFile.c_str() );
+			}
+			continue;
+		}
+		objectFiles.push_back( objectFile );
+		objectSourceFiles.push_back( file );
+
+		if( file.Extension() != objectFileExtension )
+		{
+			FileSystemUtils::Path depFile = objectFile;
+			depFile.ReplaceExtension( ".d" );
+			CompileCommand compileCommand;
+			compileCommand.m_Command = flagsString + includeString
+				+ "-MD -MF \"" + depFile.m_string + "\" "
+				+ "-c \"" + file.m_string + "\" -o \"" + objectFile.m_string + "\"";
+			compileCommand.m_SourceFile = file;
+			compileCommand.m_ObjectFile = objectFile;
+			if( bUseObjectCache )
+			{
+				compileCommand.m_PreprocessedFile = objectFile;
+				compileCommand.m_PreprocessedFile.ReplaceExtension( ".ii" );
+				compileCommand.m_PreprocessCommand = flagsString + preprocessIncludeString
+					+ "-MD -MF \"" + depFile.m_string + "\" "
+					+ "-E \"" + file.m_string + "\" -o \"" + compileCommand.m_PreprocessedFile.m_string + "\"";
+			}
+			CompilerProcessType type = bUseObjectCache ? COMPILERPROCESS_PREPROCESS : COMPILERPROCESS_COMPILE;
+			m_pImplData->m_PendingProcesses.push_back( CompilerProcess( type, (int)m_pImplData->m_CompileCommands.size() ) );
+			m_pImplData->m_CompileCommands.push_back( compileCommand );
+		}
+		linkString += "\"" + objectFile.m_string + "\" ";
+    }
+    if( bBuildPrecompiledHeader && m_pImplData->m_CompileCommands.size() )
+    {
+        m_pImplData->m_PendingProcesses.push_front( CompilerProcess( COMPILERPROCESS_PRECOMPILED_HEADER ) );
     }
     
     // libraries to link
     for( size_t i = 0; i < linkLibraryList_.size(); ++i )
     {
-        compileString += " " + linkLibraryList_[i].m_string + " ";
+        linkString += " " + linkLibraryList_[i].m_string + " ";
     }
 
-	if( bCopyOutput )
-	{
-        compileString += "\n mv \"" + output.m_string + "\" \"" + moduleName_.m_string + "\"\n";
-	}
-
-    
-    std::cout << compileString << std::endl << std::endl;
+    // output file
+    linkString += "-o \"" + moduleName_.m_string + "\"";
+	m_pImplData->m_LinkCommand = linkString;
 
-    execl("/bin/sh", "sh", "-c", compileString.c_str(), (const char*)NULL);
+    m_pImplData->UpdateProcesses();
 }
 
 
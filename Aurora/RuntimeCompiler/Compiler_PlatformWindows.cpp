@@ -85,11 +85,15 @@ public:
 	bool				m_bFindVS;
 	CmdProcess          m_CmdProcess;
 	ICompilerLogger*	m_pLogger;
+	CompileTimings		m_CompileTimings;
+	TimePoint			m_CompileStartTime;
+	bool				m_bCompileTimed;
 };
 
 Compiler::Compiler() 
 	: m_pImplData( 0 )
     , m_bFastCompileMode( false )
+    , m_pObjectCache( 0 )
 {
 }
 
@@ -103,9 +107,29 @@ std::string Compiler::GetObjectFileExtension() const
 	return ".obj";
 }
 
+FileSystemUtils::Path Compiler::GetObjectFilePath( const FileSystemUtils::Path& sourceFile_, const CompilerOptions& compilerOptions_ ) const
+{
+	// cl writes each object to the intermediate directory under the source file's name
+	FileSystemUtils::Path objectFile = compilerOptions_.intermediatePath / sourceFile_.Filename();
+	objectFile.ReplaceExtension( GetObjectFileExtension() );
+	return objectFile;
+}
+
+uint64_t Compiler::GetCompileCommandHash( const CompilerOptions& compilerOptions_ ) const
+{
+	// cl does not output dependency information in a form we can use, so no DependencyRecord is written
+	(void)compilerOptions_;
+	return 0;
+}
+
 bool Compiler::GetIsComplete() const
 {
     bool bComplete = m_pImplData->m_CmdProcess.m_bIsComplete;
+    if( bComplete && !m_pImplData->m_bCompileTimed )
+    {
+        m_pImplData->m_bCompileTimed = true;
+        m_pImplData->m_CompileTimings.totalSeconds = GetSecondsSince( m_pImplData->m_CompileStartTime );
+    }
     if( bComplete & !m_bFastCompileMode )
     {
         m_pImplData->m_CmdProcess.CleanupProcessAndPipes();
@@ -113,6 +137,26 @@ bool Compiler::GetIsComplete() const
 	return bComplete;
 }
 
+bool Compiler::WaitForComplete( unsigned int maxMilliseconds_ ) const
+{
+    // completion is set by the output reader thread, so poll it at a short interval
+    TimePoint startTime = GetTimeNow();
+    while( !GetIsComplete() )
+    {
+        if( GetSecondsSince( startTime ) * 1000.0 >= maxMilliseconds_ )
+        {
+            return false;
+        }
+        Sleep( 1 );
+    }
+    return true;
+}
+
+const CompileTimings& Compiler::GetCompileTimings() const
+{
+	return m_pImplData->m_CompileTimings;
+}
+
 void Compiler::Initialise( ICompilerLogger * pLogger )
 {
 	m_pImplData = new PlatformCompilerImplData;
@@ -163,6 +207,9 @@ void Compiler::RunCompile(	const std::vector<FileSystemUtils::Path>&	filesToComp
         return;
     }
 	m_pImplData->m_CmdProcess.m_bIsComplete = false;
+	m_pImplData->m_CompileTimings.Clear();
+	m_pImplData->m_CompileStartTime = GetTimeNow();
+	m_pImplData->m_bCompileTimed = false;
 	//optimization and c runtime
 #ifdef _DEBUG
 	std::string flags = "/nologo /Z7 /FC /utf-8 /MDd /LDd ";
@@ -593,6 +640,7 @@ void ReadAndHandleOutputThread( LPVOID arg )
 PlatformCompilerImplData::PlatformCompilerImplData()
 	: m_bFindVS(true)
 	, m_pLogger(NULL)
+	, m_bCompileTimed(true)
 {
 }
 
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "FileSystemUtils.h"
+
+// 64bit FNV-1a hash, used for hashing compile command lines and file contents.
+// Pass in a previous result as hash_ to hash multiple items together.
+static const uint64_t c_HashSeed = 14695981039346656037ULL;
+inline uint64_t HashData( const void* pData_, size_t size_, uint64_t hash_ = c_HashSeed )
+{
+	const unsigned char* pBytes = (const unsigned char*)pData_;
+	for( size_t i = 0; i < size_; ++i )
+	{
+		hash_ ^= pBytes[i];
+		hash_ *= 1099511628211ULL;
+	}
+	return hash_;
+}
+
+inline uint64_t HashString( const std::string& string_, uint64_t hash_ = c_HashSeed )
+{
+	return HashData( string_.c_str(), string_.size(), hash_ );
+}
+
+// DependencyRecord - stored next to an object file by compilers which can report dependencies,
+// holding all the files the object was built from and a hash of the command line used.
+// BuildTool uses this to decide whether an object file can be reused.
+struct DependencyRecord
+{
+	DependencyRecord()
+		: compileCommandHash( 0 )
+	{
+	}
+
+	uint64_t							compileCommandHash;
+	std::vector<FileSystemUtils::Path>	dependencies;
+
+	static FileSystemUtils::Path GetRecordPath( const FileSystemUtils::Path& objectFile_ )
+	{
+		FileSystemUtils::Path recordPath = objectFile_;
+		recordPath.ReplaceExtension( GetExtension() );
+		return recordPath;
+	}
+
+	static const char* GetExtension()
+	{
+		return ".dep";
+	}
+
+	// Returns true if all dependencies exist and are older than targetTime_
+	bool GetAreDependenciesOlderThan( FileSystemUtils::filetime_t targetTime_ ) const
+	{
+		for( size_t i = 0; i < dependencies.size(); ++i )
+		{
+			if( !dependencies[i].Exists() || dependencies[i].GetLastWriteTime() >= targetTime_ )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Parse make format dependencies as output by gcc and clang -MD, i.e. "target.o: dep1 dep2 \"
+	// Only a single target is supported.
+	void ParseMakeDependencies( const std::string& contents_ )
+	{
+		dependencies.clear();
+		size_t pos = contents_.find( ": " );
+		if( pos == std::string::npos )
+		{
+			return;
+		}
+
+		std::string current;
+		for( size_t i = pos + 1; i < contents_.size(); ++i )
+		{
+			char c = contents_[i];
+			char next = i + 1 < contents_.size() ? contents_[i+1] : 0;
+			if( '\\' == c && ( ' ' == next || '#' == next ) )
+			{
+				current += next; // escaped character in filename
+				++i;
+			}
+			else if( '$' == c && '$' == next )
+			{
+				current += '$';
+				++i;
+			}
+			else if( '\\' == c && ( '\n' == next || '\r' == next ) )
+			{
+				// line continuation, whitespace handled on next loop
+			}
+			else if( ' ' == c || '\t' == c || '\n' == c || '\r' == c )
+			{
+				if( current.size() )
+				{
+					dependencies.push_back( current );
+					current.clear();
+				}
+			}
+			else
+			{
+				current += c;
+			}
+		}
+		if( current.size() )
+		{
+			dependencies.push_back( current );
+		}
+	}
+
+	bool Load( const FileSystemUtils::Path& recordFile_ )
+	{
+		dependencies.clear();
+		FILE* pFile = FileSystemUtils::fopen( recordFile_, "rb" );
+		if( !pFile )
+		{
+			return false;
+		}
+		bool bValid = 1 == fscanf( pFile, "%" SCNx64 "\n", &compileCommandHash );
+		char line[4096];
+		while( bValid && fgets( line, sizeof( line ), pFile ) )
+		{
+			std::string dependency = line;
+			while( dependency.size() && ( dependency.back() == '\n' || dependency.back() == '\r' ) )
+			{
+				dependency.pop_back();
+			}
+			if( dependency.size() )
+			{
+				dependencies.push_back( dependency );
+			}
+		}
+		fclose( pFile );
+		return bValid;
+	}
+
+	bool Save( const FileSystemUtils::Path& recordFile_ ) const
+	{
+		FILE* pFile = FileSystemUtils::fopen( recordFile_, "wb" );
+		if( !pFile )
+		{
+			return false;
+		}
+		fprintf( pFile, "%" PRIx64 "\n", compileCommandHash );
+		for( size_t i = 0; i < dependencies.size(); ++i )
+		{
+			fprintf( pFile, "%s\n", dependencies[i].c_str() );
+		}
+		fclose( pFile );
+		return true;
+	}
+};
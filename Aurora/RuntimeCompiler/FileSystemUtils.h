@@ -46,6 +46,8 @@
     #include <unistd.h>
     #include <dirent.h>
     #include <assert.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
 	#define FILESYSTEMUTILS_SEPERATORS "/"
 #endif
 
@@ -804,6 +806,100 @@ namespace FileSystemUtils
         
     };
 
+    // read only memory mapping of a whole file, GetData() is NULL if the file could not be mapped
+    class MappedFile
+    {
+    private:
+        const char* m_pData;
+        uint64_t    m_size;
+#ifdef _WIN32
+        void ImpCtor( const Path& path_ )
+        {
+            std::wstring temp = _Win32Utf8ToUtf16( path_.m_string );
+            m_hFile = CreateFileW( temp.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+            m_hMapping = NULL;
+            LARGE_INTEGER size;
+            if( INVALID_HANDLE_VALUE == m_hFile || !GetFileSizeEx( m_hFile, &size ) || 0 == size.QuadPart )
+            {
+                return;
+            }
+            m_hMapping = CreateFileMappingW( m_hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+            if( m_hMapping )
+            {
+                m_pData = (const char*)MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 );
+                m_size = m_pData ? (uint64_t)size.QuadPart : 0;
+            }
+        }
+        void ImpDtor()
+        {
+            if( m_pData )
+            {
+                UnmapViewOfFile( m_pData );
+            }
+            if( m_hMapping )
+            {
+                CloseHandle( m_hMapping );
+            }
+            if( INVALID_HANDLE_VALUE != m_hFile )
+            {
+                CloseHandle( m_hFile );
+            }
+        }
+
+        HANDLE m_hFile;
+        HANDLE m_hMapping;
+#else
+        void ImpCtor( const Path& path_ )
+        {
+            int fd = open( path_.c_str(), O_RDONLY );
+            if( fd < 0 )
+            {
+                return;
+            }
+            struct stat buffer;
+            if( 0 == fstat( fd, &buffer ) && buffer.st_size > 0 )
+            {
+                void* pData = mmap( 0, (size_t)buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                if( MAP_FAILED != pData )
+                {
+                    m_pData = (const char*)pData;
+                    m_size = (uint64_t)buffer.st_size;
+                }
+            }
+            close( fd ); // the mapping keeps the file open
+        }
+        void ImpDtor()
+        {
+            if( m_pData )
+            {
+                munmap( (void*)m_pData, (size_t)m_size );
+            }
+        }
+#endif
+        MappedFile( const MappedFile& );
+        MappedFile& operator=( const MappedFile& );
+    public:
+        MappedFile( const Path& path_ )
+        : m_pData( 0 )
+        , m_size( 0 )
+        {
+            ImpCtor( path_ );
+        }
+        ~MappedFile()
+        {
+            ImpDtor();
+        }
+
+        const char* GetData() const
+        {
+            return m_pData;
+        }
+        uint64_t GetSize() const
+        {
+            return m_size;
+        }
+    };
+
 
 }
 
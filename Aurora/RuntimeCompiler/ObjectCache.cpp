@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "ObjectCache.h"
+#include "ICompilerLogger.h"
+
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+
+using namespace std;
+using namespace FileSystemUtils;
+
+static const char c_CacheEntryExtension[] = ".cacheobj";
+
+static bool CopyFileContents( const Path& source_, const Path& destination_ )
+{
+	FILE* pSource = FileSystemUtils::fopen( source_, "rb" );
+	if( !pSource )
+	{
+		return false;
+	}
+	FILE* pDestination = FileSystemUtils::fopen( destination_, "wb" );
+	if( !pDestination )
+	{
+		fclose( pSource );
+		return false;
+	}
+
+	bool bSuccess = true;
+	char buffer[ 64 * 1024 ];
+	size_t numRead;
+	while( ( numRead = fread( buffer, 1, sizeof( buffer ), pSource ) ) > 0 )
+	{
+		if( fwrite( buffer, 1, numRead, pDestination ) != numRead )
+		{
+			bSuccess = false;
+			break;
+		}
+	}
+	fclose( pSource );
+	fclose( pDestination );
+	return bSuccess;
+}
+
+ObjectCache::ObjectCache()
+	: m_pLogger( 0 )
+	, m_MaxSize( 0 )
+	, m_CurrentSize( 0 )
+	, m_NumHits( 0 )
+	, m_NumMisses( 0 )
+{
+}
+
+ObjectCache::~ObjectCache()
+{
+}
+
+void ObjectCache::Initialise( ICompilerLogger * pLogger )
+{
+	m_pLogger = pLogger;
+}
+
+void ObjectCache::SetCache( const Path& directory_, uint64_t maxSize_ )
+{
+	m_Directory = directory_;
+	m_MaxSize = maxSize_;
+	m_CurrentSize = 0;
+	if( !GetIsEnabled() )
+	{
+		return;
+	}
+
+	if( !m_Directory.Exists() )
+	{
+		if( !m_Directory.CreateDir() )
+		{
+			if( m_pLogger ) { m_pLogger->LogError( "Error creating object cache folder \"%s\", object cache disabled\n", m_Directory.c_str() ); }
+			m_MaxSize = 0;
+			return;
+		}
+	}
+
+	// entries persist between runs, so get the current size
+	PathIterator pathIter( m_Directory );
+	while( ++pathIter )
+	{
+		if( pathIter.GetPath().Extension() == c_CacheEntryExtension )
+		{
+			m_CurrentSize += pathIter.GetPath().GetFileSize();
+		}
+	}
+	Evict();
+}
+
+Path ObjectCache::GetEntryPath( uint64_t key_ ) const
+{
+	char name[32];
+	snprintf( name, sizeof( name ), "%016" PRIx64 "%s", key_, c_CacheEntryExtension );
+	return m_Directory / name;
+}
+
+bool ObjectCache::Fetch( uint64_t key_, const Path& objectFile_ )
+{
+	Path entry = GetEntryPath( key_ );
+	if( entry.Exists() && CopyFileContents( entry, objectFile_ ) )
+	{
+		// write time is used as the last access time for eviction
+		entry.SetLastWriteTime( FileSystemUtils::GetCurrentTime() );
+		++m_NumHits;
+		return true;
+	}
+	++m_NumMisses;
+	return false;
+}
+
+void ObjectCache::Store( uint64_t key_, const Path& objectFile_ )
+{
+	Path entry = GetEntryPath( key_ );
+	if( entry.Exists() )
+	{
+		m_CurrentSize -= std::min( m_CurrentSize, entry.GetFileSize() );
+	}
+
+	// copy to a temporary file first so a partially written entry is never used
+	Path temp = entry;
+	temp.ReplaceExtension( ".temp" );
+	if( !CopyFileContents( objectFile_, temp ) )
+	{
+		temp.Remove();
+		if( m_pLogger ) { m_pLogger->LogWarning( "Could not add %s to object cache\n", objectFile_.c_str() ); }
+		return;
+	}
+	entry.Remove();
+	if( !temp.Rename( entry ) )
+	{
+		temp.Remove();
+		return;
+	}
+	m_CurrentSize += entry.GetFileSize();
+	Evict();
+}
+
+struct CacheEntry
+{
+	Path						path;
+	FileSystemUtils::filetime_t	lastAccessTime;
+	uint64_t					size;
+
+	bool operator<( const CacheEntry& rhs_ ) const
+	{
+		return lastAccessTime < rhs_.lastAccessTime;
+	}
+};
+
+void ObjectCache::Evict()
+{
+	if( m_CurrentSize <= m_MaxSize )
+	{
+		return;
+	}
+
+	std::vector<CacheEntry> entries;
+	PathIterator pathIter( m_Directory );
+	while( ++pathIter )
+	{
+		if( pathIter.GetPath().Extension() == c_CacheEntryExtension )
+		{
+			CacheEntry entry;
+			entry.path = pathIter.GetPath();
+			entry.lastAccessTime = entry.path.GetLastWriteTime();
+			entry.size = entry.path.GetFileSize();
+			entries.push_back( entry );
+		}
+	}
+	std::sort( entries.begin(), entries.end() );
+
+	// remove least recently used entries until we are under the limit
+	for( size_t i = 0; i < entries.size() && m_CurrentSize > m_MaxSize; ++i )
+	{
+		if( entries[i].path.Remove() )
+		{
+			m_CurrentSize -= std::min( m_CurrentSize, entries[i].size );
+		}
+	}
+}
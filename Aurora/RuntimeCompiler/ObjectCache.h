@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#include <stdint.h>
+#include "FileSystemUtils.h"
+
+struct ICompilerLogger;
+
+// ObjectCache - an on disk cache of compiled object files keyed by a hash of the preprocessed
+// source and compile options, so reverting an edit or restarting the application does not
+// require a recompile. Entries are evicted least recently used first once the cache exceeds
+// its maximum size. Used by compilers which support it (currently Posix only).
+class ObjectCache
+{
+public:
+	ObjectCache();
+	~ObjectCache();
+	void Initialise( ICompilerLogger * pLogger );
+
+	// Sets the directory and maximum size in bytes of the cache. A max size of 0 disables the cache.
+	void SetCache( const FileSystemUtils::Path& directory_, uint64_t maxSize_ );
+
+	bool GetIsEnabled() const
+	{
+		return m_MaxSize > 0;
+	}
+
+	// Copies the cached object file for key_ to objectFile_. Returns false on a cache miss.
+	bool Fetch( uint64_t key_, const FileSystemUtils::Path& objectFile_ );
+
+	// Adds a copy of objectFile_ to the cache, evicting old entries if needed.
+	void Store( uint64_t key_, const FileSystemUtils::Path& objectFile_ );
+
+	unsigned int GetNumHits() const
+	{
+		return m_NumHits;
+	}
+
+	unsigned int GetNumMisses() const
+	{
+		return m_NumMisses;
+	}
+
+private:
+	FileSystemUtils::Path	GetEntryPath( uint64_t key_ ) const;
+	void					Evict();
+
+	ICompilerLogger*		m_pLogger;
+	FileSystemUtils::Path	m_Directory;
+	uint64_t				m_MaxSize;
+	uint64_t				m_CurrentSize;
+	unsigned int			m_NumHits;
+	unsigned int			m_NumMisses;
+};
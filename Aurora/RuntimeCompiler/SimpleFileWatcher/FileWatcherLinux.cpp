@@ -31,124 +31,395 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <limits.h>
+#include <dirent.h>
+#include <vector>
 #include <sys/inotify.h>
 
-#define BUFF_SIZE ((sizeof(struct inotify_event)+FILENAME_MAX)*1024)
+// read buffer for the watcher thread, which can read repeatedly so does not need to be large
+#define BUFF_SIZE ((sizeof(struct inotify_event)+NAME_MAX+1)*256)
+#define EVENT_QUEUE_SIZE 4096
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MOVED_FROM | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF)
 
 namespace FW
 {
 
 	struct WatchStruct
 	{
-		WatchID mWatchID;
+		WatchID mWatchID;		// id reported to the listener, the root's descriptor for subdirectories
+		int mDescriptor;		// inotify descriptor for this directory
 		String mDirName;
-		FileWatchListener* mListener;		
+		FileWatchListener* mListener;
+		bool mRecursive;
+		std::vector<int> mSubWatches;	// descriptors of subdirectory watches, root only
+	};
+
+	struct WatchEvent
+	{
+		WatchID mWatchID;
+		unsigned long mAction;
+		String mFilename;
+	};
+
+	/// Bounded lock free queue, pushed to by the watcher thread and popped by update().
+	/// Each slot is only accessed by one thread at a time, as determined by the read and write indices.
+	class FileWatcherLinux::EventQueue
+	{
+	public:
+		EventQueue(size_t size)
+			: mEvents(size)
+			, mRead(0)
+			, mWrite(0)
+		{
+		}
+
+		/// returns false if the queue is full
+		bool push(WatchEvent& event)
+		{
+			size_t write = mWrite.load(std::memory_order_relaxed);
+			size_t next = (write + 1) % mEvents.size();
+			if(next == mRead.load(std::memory_order_acquire))
+				return false;
+			mEvents[write].mWatchID = event.mWatchID;
+			mEvents[write].mAction = event.mAction;
+			mEvents[write].mFilename.m_string.swap(event.mFilename.m_string);
+			mWrite.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/// returns false if the queue is empty
+		bool pop(WatchEvent& event)
+		{
+			size_t read = mRead.load(std::memory_order_relaxed);
+			if(read == mWrite.load(std::memory_order_acquire))
+				return false;
+			event.mWatchID = mEvents[read].mWatchID;
+			event.mAction = mEvents[read].mAction;
+			event.mFilename.m_string.swap(mEvents[read].mFilename.m_string);
+			mRead.store((read + 1) % mEvents.size(), std::memory_order_release);
+			return true;
+		}
+
+	private:
+		std::vector<WatchEvent> mEvents;
+		std::atomic<size_t> mRead;
+		std::atomic<size_t> mWrite;
 	};
 
 	//--------
 	FileWatcherLinux::FileWatcherLinux()
+		: mLastWatchID(0)
+		, mEvents(new EventQueue(EVENT_QUEUE_SIZE))
+		, mStop(false)
 	{
-		mFD = inotify_init();
+		mWakePipe[0] = mWakePipe[1] = -1;
+		mFD = inotify_init1(IN_CLOEXEC);
 		if (mFD < 0)
+		{
+			fprintf (stderr, "Error: %s\n", strerror(errno));
+			return;
+		}
+		if (pipe(mWakePipe) != 0)
+		{
 			fprintf (stderr, "Error: %s\n", strerror(errno));
-		
-		mTimeOut.tv_sec = 0;
-		mTimeOut.tv_usec = 0;
-	   		
-		FD_ZERO(&mDescriptorSet);
+			mWakePipe[0] = mWakePipe[1] = -1;
+			return;
+		}
+		fcntl(mWakePipe[0], F_SETFD, FD_CLOEXEC);
+		fcntl(mWakePipe[1], F_SETFD, FD_CLOEXEC);
+
+		mThread = std::thread(&FileWatcherLinux::threadFunc, this);
 	}
 
 	//--------
 	FileWatcherLinux::~FileWatcherLinux()
 	{
+		if(mThread.joinable())
+		{
+			mStop = true;
+			char wake = 0;
+			ssize_t ret = write(mWakePipe[1], &wake, 1);
+			(void)ret;
+			mThread.join();
+		}
+		if(mWakePipe[0] >= 0)
+		{
+			close(mWakePipe[0]);
+			close(mWakePipe[1]);
+		}
+
 		WatchMap::iterator iter = mWatches.begin();
 		WatchMap::iterator end = mWatches.end();
 		for(; iter != end; ++iter)
 		{
+			inotify_rm_watch(mFD, iter->first);
 			delete iter->second;
 		}
 		mWatches.clear();
+		mWatchPaths.clear();
+
+		if(mFD >= 0)
+			close(mFD);
+		delete mEvents;
 	}
 
 	//--------
 	WatchID FileWatcherLinux::addWatch(const String& directory, FileWatchListener* watcher, bool recursive)
 	{
-        (void)recursive;
-		const char* pDir = directory.c_str();
-		int wd = inotify_add_watch (mFD, pDir,
-			IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MOVED_FROM | IN_DELETE | IN_MODIFY | IN_ATTRIB );
+		WatchStruct* pWatch = addDescriptor(directory, watcher, 0);
+		if(!pWatch)
+		{
+			WatchPathMap::iterator iter = mWatchPaths.find(directory.m_string);
+			return iter != mWatchPaths.end() ? iter->second->mWatchID : -1;
+		}
+
+		pWatch->mRecursive = recursive;
+		if(recursive)
+			addSubdirectories(pWatch, directory, false);
+
+		return pWatch->mWatchID;
+	}
+
+	//--------
+	WatchStruct* FileWatcherLinux::addDescriptor(const String& directory, FileWatchListener* watcher, WatchStruct* root)
+	{
+		int wd = inotify_add_watch(mFD, directory.c_str(), WATCH_MASK);
+		if(wd < 0)
+			return 0;
+
+		// inotify returns the existing descriptor if this directory is already watched
+		if(mWatches.find(wd) != mWatches.end())
+			return 0;
 
 		WatchStruct* pWatch = new WatchStruct();
 		pWatch->mListener = watcher;
-		pWatch->mWatchID = wd;
+		pWatch->mWatchID = root ? root->mWatchID : wd;
+		pWatch->mDescriptor = wd;
 		pWatch->mDirName = directory;
-		
+		pWatch->mRecursive = root ? true : false;
+
 		mWatches.insert(std::make_pair(wd, pWatch));
-	
-		return wd;
+		mWatchPaths[directory.m_string] = pWatch;
+		if(root)
+			root->mSubWatches.push_back(wd);
+
+		return pWatch;
 	}
 
 	//--------
-	void FileWatcherLinux::removeWatch(const String& directory)
+	void FileWatcherLinux::addSubdirectories(WatchStruct* root, const String& directory, bool reportFiles)
 	{
-		WatchMap::iterator iter = mWatches.begin();
-		WatchMap::iterator end = mWatches.end();
-		for(; iter != end; ++iter)
+		DIR* pDir = opendir(directory.c_str());
+		if(!pDir)
+			return;
+
+		std::vector<String> subdirs;
+		struct dirent* pEntry;
+		while((pEntry = readdir(pDir)) != 0)
 		{
-			if(directory == iter->second->mDirName)
+			if(0 == strcmp(pEntry->d_name, ".") || 0 == strcmp(pEntry->d_name, ".."))
+				continue;
+
+			String path = directory / pEntry->d_name;
+			unsigned char type = pEntry->d_type;
+			if(DT_UNKNOWN == type)
 			{
-				removeWatch(iter->first);
-				return;
+				// symbolic links are not followed, to avoid cycles
+				struct stat st;
+				if(lstat(path.c_str(), &st) != 0)
+					continue;
+				type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
 			}
+
+			if(DT_DIR == type)
+				subdirs.push_back(path);
+			else if(reportFiles && DT_REG == type && root->mListener)
+				root->mListener->handleFileAction(root->mWatchID, directory, pEntry->d_name, Actions::Add);
+		}
+		closedir(pDir);
+
+		for(size_t i = 0; i < subdirs.size(); ++i)
+		{
+			if(addDescriptor(subdirs[i], root->mListener, root))
+				addSubdirectories(root, subdirs[i], reportFiles);
 		}
 	}
 
+	//--------
+	void FileWatcherLinux::removeWatch(const String& directory)
+	{
+		WatchPathMap::iterator iter = mWatchPaths.find(directory.m_string);
+		if(iter != mWatchPaths.end())
+			removeDescriptor(iter->second->mWatchID, true);
+	}
+
 	//--------
 	void FileWatcherLinux::removeWatch(WatchID watchid)
 	{
-		WatchMap::iterator iter = mWatches.find(watchid);
+		removeDescriptor(watchid, true);
+	}
+
+	//--------
+	void FileWatcherLinux::removeDescriptor(int wd, bool removeFromInotify)
+	{
+		WatchMap::iterator iter = mWatches.find(wd);
 
 		if(iter == mWatches.end())
 			return;
 
 		WatchStruct* watch = iter->second;
 		mWatches.erase(iter);
-	
-		inotify_rm_watch(mFD, watchid);
-		
+
+		WatchPathMap::iterator pathIter = mWatchPaths.find(watch->mDirName.m_string);
+		if(pathIter != mWatchPaths.end() && pathIter->second == watch)
+			mWatchPaths.erase(pathIter);
+
+		if(removeFromInotify)
+			inotify_rm_watch(mFD, wd);
+
+		if(watch->mWatchID == (WatchID)wd)
+		{
+			// root, remove all subdirectory watches
+			for(size_t i = 0; i < watch->mSubWatches.size(); ++i)
+				removeDescriptor(watch->mSubWatches[i], true);
+		}
+		else
+		{
+			WatchMap::iterator rootIter = mWatches.find(watch->mWatchID);
+			if(rootIter != mWatches.end())
+			{
+				std::vector<int>& subWatches = rootIter->second->mSubWatches;
+				for(size_t i = 0; i < subWatches.size(); ++i)
+				{
+					if(subWatches[i] == wd)
+					{
+						subWatches[i] = subWatches.back();
+						subWatches.pop_back();
+						break;
+					}
+				}
+			}
+		}
+
 		delete watch;
 		watch = 0;
 	}
 
 	//--------
-	void FileWatcherLinux::update()
+	void FileWatcherLinux::removeSubdirectory(WatchStruct* root, const String& directory)
 	{
-		FD_SET(mFD, &mDescriptorSet);
-
-		int ret = select(mFD + 1, &mDescriptorSet, NULL, NULL, &mTimeOut);
-		if(ret < 0)
+		// a moved directory keeps its watches under the old path, so remove them all
+		const std::string& dir = directory.m_string;
+		std::vector<int> remove;
+		WatchPathMap::iterator iter = mWatchPaths.find(dir);
+		if(iter != mWatchPaths.end())
+			remove.push_back(iter->second->mDescriptor);
+		for(size_t i = 0; i < root->mSubWatches.size(); ++i)
 		{
-			perror("select");
+			const std::string& path = mWatches[root->mSubWatches[i]]->mDirName.m_string;
+			if(path.length() > dir.length() && 0 == path.compare(0, dir.length(), dir) && '/' == path[dir.length()])
+				remove.push_back(root->mSubWatches[i]);
 		}
-		else if(FD_ISSET(mFD, &mDescriptorSet))
+		for(size_t i = 0; i < remove.size(); ++i)
+			removeDescriptor(remove[i], true);
+	}
+
+	//--------
+	void FileWatcherLinux::threadFunc()
+	{
+		std::vector<char> buff(BUFF_SIZE);
+		WatchEvent event;
+		while(!mStop)
 		{
-			ssize_t len, i = 0;
-			//char action[81+FILENAME_MAX] = {0};
-			char buff[BUFF_SIZE] = {0};
+			struct pollfd fds[2];
+			fds[0].fd = mFD;
+			fds[0].events = POLLIN;
+			fds[0].revents = 0;
+			fds[1].fd = mWakePipe[0];
+			fds[1].events = POLLIN;
+			fds[1].revents = 0;
+			int ret = poll(fds, 2, -1);
+			if(ret < 0)
+			{
+				if(EINTR == errno)
+					continue;
+				perror("poll");
+				return;
+			}
+			if(fds[1].revents)
+				return;
+			if(!(fds[0].revents & POLLIN))
+				continue;
 
-			len = read (mFD, buff, BUFF_SIZE);
-		   
+			ssize_t len = read(mFD, &buff[0], buff.size());
+			ssize_t i = 0;
 			while (i < len)
 			{
 				struct inotify_event *pevent = (struct inotify_event *)&buff[i];
-
-				WatchStruct* watch = mWatches[pevent->wd];
-				handleAction(watch, pevent->name, pevent->mask);
 				i += sizeof(struct inotify_event) + pevent->len;
+				if(pevent->wd < 0)
+					continue; // IN_Q_OVERFLOW
+
+				event.mWatchID = pevent->wd;
+				event.mAction = pevent->mask;
+				event.mFilename = pevent->len ? pevent->name : "";
+
+				// wait rather than lose events if update() has not been called recently
+				while(!mEvents->push(event))
+				{
+					if(mStop)
+						return;
+					usleep(1000);
+				}
 			}
 		}
 	}
 
+	//--------
+	void FileWatcherLinux::update()
+	{
+		WatchEvent event;
+		while(mEvents->pop(event))
+		{
+			// the watch may have been removed after the event was queued
+			WatchMap::iterator iter = mWatches.find(event.mWatchID);
+			if(iter == mWatches.end())
+				continue;
+			WatchStruct* watch = iter->second;
+
+			if(event.mAction & (IN_DELETE_SELF | IN_IGNORED))
+			{
+				// inotify has removed the watch, so only our records need removing
+				removeDescriptor(event.mWatchID, false);
+				continue;
+			}
+
+			if(watch->mRecursive && (event.mAction & IN_ISDIR))
+			{
+				WatchMap::iterator rootIter = mWatches.find(watch->mWatchID);
+				if(rootIter != mWatches.end())
+				{
+					WatchStruct* root = rootIter->second;
+					String subdir = watch->mDirName / event.mFilename;
+					if(event.mAction & (IN_CREATE | IN_MOVED_TO))
+					{
+						// files may be created before the watch is added, so report those found
+						handleAction(watch, event.mFilename, event.mAction);
+						if(addDescriptor(subdir, root->mListener, root))
+							addSubdirectories(root, subdir, true);
+						continue;
+					}
+					if(event.mAction & IN_MOVED_FROM)
+						removeSubdirectory(root, subdir);
+				}
+			}
+
+			handleAction(watch, event.mFilename, event.mAction);
+		}
+	}
+
 	//--------
 	void FileWatcherLinux::handleAction(WatchStruct* watch, const String& filename, unsigned long action)
 	{
@@ -32,18 +32,28 @@
 
 #if FILEWATCHER_PLATFORM == FILEWATCHER_PLATFORM_LINUX
 
-#include <map>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <atomic>
 #include <sys/types.h>
 
 namespace FW
 {
-	/// Implementation for Linux based on inotify.
+	/// Implementation for Linux based on inotify. A background thread blocks on the inotify
+	/// descriptor and queues events, which are dispatched to listeners from update().
 	/// @class FileWatcherLinux
 	class FileWatcherLinux : public FileWatcherImpl
 	{
 	public:
-		/// type for a map from WatchID to WatchStruct pointer
-		typedef std::map<WatchID, WatchStruct*> WatchMap;
+		/// single producer single consumer queue of events read by the watcher thread
+		class EventQueue;
+
+		/// type for a map from inotify watch descriptor to WatchStruct pointer
+		typedef std::unordered_map<int, WatchStruct*> WatchMap;
+
+		/// type for a map from directory path to WatchStruct pointer
+		typedef std::unordered_map<std::string, WatchStruct*> WatchPathMap;
 
 	public:
 		///
@@ -54,33 +64,54 @@ namespace FW
 		///
 		virtual ~FileWatcherLinux();
 
-		/// Add a directory watch
+		/// Add a directory watch. A recursive watch adds an inotify watch for each subdirectory,
+		/// including those created later, all reported to the listener under the returned WatchID.
 		/// @exception FileNotFoundException Thrown when the requested directory does not exist
 		WatchID addWatch(const String& directory, FileWatchListener* watcher, bool recursive);
 
-		/// Remove a directory watch. This is a brute force lazy search O(nlogn).
+		/// Remove a directory watch. This is a hash lookup O(1).
 		void removeWatch(const String& directory);
 
-		/// Remove a directory watch. This is a map lookup O(logn).
+		/// Remove a directory watch and any subdirectory watches. This is a hash lookup O(1).
 		void removeWatch(WatchID watchid);
 
-		/// Updates the watcher. Must be called often.
+		/// Dispatches events queued by the watcher thread. Must be called often.
 		void update();
 
 		/// Handles the action
 		void handleAction(WatchStruct* watch, const String& filename, unsigned long action);
 
 	private:
-		/// Map of WatchID to WatchStruct pointers
+		/// Map of watch descriptor to WatchStruct pointers, for every watched directory
 		WatchMap mWatches;
+		/// Map of directory path to WatchStruct pointers
+		WatchPathMap mWatchPaths;
 		/// The last watchid
 		WatchID mLastWatchID;
 		/// inotify file descriptor
 		int mFD;
-		/// time out data
-		struct timeval mTimeOut;
-		/// File descriptor set
-		fd_set mDescriptorSet;
+		/// Written to on destruction to wake the watcher thread
+		int mWakePipe[2];
+		/// Events read by the watcher thread waiting for update()
+		EventQueue* mEvents;
+		/// Set on destruction to stop the watcher thread
+		std::atomic<bool> mStop;
+		/// Reads the inotify descriptor
+		std::thread mThread;
+
+		void threadFunc();
+
+		/// Adds an inotify watch for a single directory, returns 0 on failure or if already watched
+		WatchStruct* addDescriptor(const String& directory, FileWatchListener* watcher, WatchStruct* root);
+
+		/// Adds watches for all subdirectories of directory, optionally reporting files found as added
+		void addSubdirectories(WatchStruct* root, const String& directory, bool reportFiles);
+
+		/// Removes a watch and, for a recursive root, all its subdirectory watches
+		void removeDescriptor(int wd, bool removeFromInotify);
+
+		/// Removes the watch for directory and any of its subdirectories from a recursive watch
+		void removeSubdirectory(WatchStruct* root, const String& directory);
 
 	};//end FileWatcherLinux
 
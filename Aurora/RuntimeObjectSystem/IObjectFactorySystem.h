@@ -34,6 +34,30 @@ struct IObjectFactoryListener
     virtual ~IObjectFactoryListener() {}
 };
 
+// Wall clock timings in seconds of the phases of an object swap in AddConstructors.
+// Phases not reached due to an exception are 0.
+struct ObjectSwapTimings
+{
+	ObjectSwapTimings()
+		: serializeOut( 0.0 )
+		, constructNew( 0.0 )
+		, serializeIn( 0.0 )
+		, autoConstructSingletons( 0.0 )
+		, initAndSerializeTest( 0.0 )
+		, deleteOld( 0.0 )
+		, total( 0.0 )
+	{
+	}
+
+	double serializeOut;
+	double constructNew;
+	double serializeIn;
+	double autoConstructSingletons;
+	double initAndSerializeTest;
+	double deleteOld;
+	double total;			// all of AddConstructors, including restoring objects on an exception
+};
+
 struct IObjectFactorySystem
 {
 #if RCCPP_ALLOCATOR_INTERFACE
@@ -48,6 +72,9 @@ struct IObjectFactorySystem
 	virtual void				GetAll(IAUDynArray<IObjectConstructor*> &constructors) const = 0;
 	virtual IObject*			GetObject( ObjectId id ) const = 0;
 
+	// true if the constructor is current for its type, is in the undo history or has live objects
+	virtual bool				GetIsConstructorInUse( IObjectConstructor* pConstructor_ ) const = 0;
+
 	virtual void				AddListener(IObjectFactoryListener* pListener) = 0;
 	virtual void				RemoveListener(IObjectFactoryListener* pListener) = 0;
 	virtual void				SetLogger( ICompilerLogger* pLogger ) = 0;
@@ -73,6 +100,39 @@ struct IObjectFactorySystem
 	// history location is 0 for current, +ve number for a previous location
 	// undo calls causes location +1, redo -1 bounded by HistorySize and 0.
 	virtual int					GetObjectContstructorHistoryLocation() = 0;
+
+	// timings of the last object swap done by AddConstructors
+	virtual const ObjectSwapTimings& GetLastObjectSwapTimings() const = 0;
+
+	// incremental object swap only serializes and initialises objects of changed types, and
+	// of types registered as dependent on a changed type with AddSwapDependency.
+	// Off by default, as objects holding pointers to other objects must declare this.
+	virtual void				SetIncrementalObjectSwap( bool bIncremental ) = 0;
+	virtual bool				GetIncrementalObjectSwap() const = 0;
+
+	// declares that objects of type dependentType_ hold pointers into objects of type dependencyType_,
+	// so need serializing in and initialising when dependencyType_ is swapped. Types are class names.
+	virtual void				AddSwapDependency( const char* dependentType_, const char* dependencyType_ ) = 0;
+	virtual void				RemoveSwapDependency( const char* dependentType_, const char* dependencyType_ ) = 0;
+
+	// parallel object swap spreads serializing out, constructing and serializing in the objects of
+	// a project's types over worker threads, each with its own serializer and RuntimeProtector.
+	// Only enable for projects whose object constructors, allocators and Serialize functions are thread safe.
+	virtual void				SetParallelObjectSwap( bool bParallel_, unsigned short projectId_ = 0 ) = 0;
+	virtual bool				GetParallelObjectSwap( unsigned short projectId_ = 0 ) const = 0;
+
+	// number of threads used by parallel object swap, including the calling thread.
+	// 0 (default) uses the hardware concurrency.
+	virtual void				SetObjectSwapThreadCount( unsigned int numThreads_ ) = 0;
+	virtual unsigned int		GetObjectSwapThreadCount() const = 0;
+
+	// snapshots save the serialized properties of all objects to a file, and restore them in a later
+	// process by matching type names, for fast restart and crash recovery. Restored objects keep their
+	// ObjectIds and get Init( false ) after all are serialized in. Types with no live objects are constructed
+	// from the snapshot, for other types only objects with a live ObjectId are restored into.
+	// Only trivially copyable properties are saved, pointer properties must be rebuilt from ObjectIds in Init.
+	virtual bool				SaveSnapshot( const char* filename_ ) = 0;
+	virtual bool				LoadSnapshot( const char* filename_ ) = 0;
 };
 
 
@@ -21,6 +21,8 @@
 #define IRUNTIMEOBJECTSYSTEM_INCLUDED
 
 #include "../RuntimeCompiler/CompileOptions.h"
+#include "../RuntimeCompiler/CompileTimings.h"
+#include "IObjectFactorySystem.h"
 
 struct ICompilerLogger;
 struct IObjectFactorySystem;
@@ -40,6 +42,32 @@ enum TestBuildResult
     TESTBUILDRRESULT_OBJECT_SWAP_FAIL,   // build succeeded, module loaded but errors on swapping
 };
 
+// Wall clock timings in seconds of the phases of a reload, see IRuntimeObjectSystem::GetLastReloadReport
+struct ReloadReport
+{
+    ReloadReport()
+        : projectId( 0 )
+        , fileChangeToCompileSeconds( 0.0 )
+        , startCompileSeconds( 0.0 )
+        , waitForLoadSeconds( 0.0 )
+        , loadModuleSeconds( 0.0 )
+        , setupConstructorsSeconds( 0.0 )
+        , totalSeconds( 0.0 )
+        , bSucceeded( false )
+    {
+    }
+
+    unsigned short      projectId;
+    double              fileChangeToCompileSeconds; // file change notification to compile start, 0 if not started by a file change
+    double              startCompileSeconds;        // build list setup, object file checks and starting compile processes
+    CompileTimings      compile;
+    double              waitForLoadSeconds;         // compile complete detected until LoadCompiledModule called
+    double              loadModuleSeconds;          // loading the module and getting its per module interface
+    double              setupConstructorsSeconds;   // runtime file tracking setup for new constructors
+    ObjectSwapTimings   objectSwap;
+    double              totalSeconds;               // file change notification (or compile start) to end of object swap
+    bool                bSucceeded;                 // module loaded, object swap may still have failed
+};
 
 struct ITestBuildNotifier
 {
@@ -56,7 +84,8 @@ struct ITestBuildNotifier
     // Notifier should implement sleep function for a small interval - say 10-100ms.
     // Additionally, any message queues / view updates should be handled here, especially
     // on Win32 where the file change notifiers need the message queue to be processed.
-    // Default uses usleep or Sleep, dispatches messages on Win32 and returns true.
+    // Default waits up to 100ms for a compile in progress to complete, or sleeps for 100ms if there is none,
+    // dispatches messages on Win32 and returns true.
     //
     // Return true to continue with testing or false to end test.
     virtual bool TestBuildWaitAndUpdate() = 0;
@@ -88,6 +117,21 @@ struct IRuntimeObjectSystem : public ITestBuildNotifier
     // Mainly useful for detected wether a new module has been loaded by checking for change
     virtual unsigned int GetNumberLoadedModules() const = 0;
 
+    // Timings for the last reload (compile and load of a module) which reached LoadCompiledModule
+    virtual const ReloadReport& GetLastReloadReport() const = 0;
+
+    // Modules superseded by later reloads are unloaded and their temporary files deleted once none of their
+    // constructors are current, in the undo history or have live objects. This is checked after each
+    // LoadCompiledModule, or call UnloadUnusedModules after changing the undo history. On by default.
+    // Modules whose code or static data is referenced from outside their objects, for example through
+    // function pointers or string literals, can be kept loaded by adding references via any of their constructors.
+    virtual void SetUnloadUnusedModules( bool bUnload_ ) = 0;
+    virtual bool GetUnloadUnusedModules() const = 0;
+    virtual void AddModuleReference(    IObjectConstructor* pConstructor_ ) = 0;
+    virtual void RemoveModuleReference( IObjectConstructor* pConstructor_ ) = 0;
+    virtual unsigned int UnloadUnusedModules() = 0;     // returns the number unloaded
+    virtual unsigned int GetNumberCurrentlyLoadedModules() const = 0;
+
 	virtual IObjectFactorySystem* GetObjectFactorySystem() const = 0;
 	virtual IFileChangeNotifier* GetFileChangeNotifier() const = 0;
     virtual ICompilerLogger*     GetLogger() const = 0;
@@ -111,6 +155,15 @@ struct IRuntimeObjectSystem : public ITestBuildNotifier
     virtual void SetOptimizationLevel( RCppOptimizationLevel optimizationLevel_,	unsigned short projectId_ = 0 ) = 0;
     virtual RCppOptimizationLevel GetOptimizationLevel(					unsigned short projectId_ = 0 ) = 0;
 
+    // Number of translation units compiled concurrently on Posix, 0 (the default) uses the hardware concurrency.
+    // On Win32 the compiler's /MP option is used instead, so this has no effect.
+    virtual void SetMaxParallelCompiles( unsigned int maxParallelCompiles_,	unsigned short projectId_ = 0 ) = 0;
+
+    // Header precompiled once per optimization level into the intermediate dir and included in all
+    // runtime source files of the project. Rebuilt when it or any header it includes changes.
+    // Currently only supported on Posix (GCC and Clang), pass NULL or "" to disable (the default).
+    virtual void SetPrecompiledHeader(          const char* path_,      unsigned short projectId_ = 0 ) = 0;
+
 	// Intermediate Dir has DEBUG in debug or RELEASE plus project optimization level appended to it.
 	// defaults to current directory plus /Runtime
     virtual void SetIntermediateDir(            const char* path_,      unsigned short projectId_ = 0 ) = 0;
@@ -121,6 +174,12 @@ struct IRuntimeObjectSystem : public ITestBuildNotifier
     // see Compiler::SetFastCompileMode
     virtual void SetFastCompileMode( bool bFast ) = 0;
 
+    // Object cache stores compiled object files keyed on preprocessed source and compile options,
+    // shared by all projects and persisting between runs. Currently only supported on Posix.
+    // path_ defaults to the default intermediate dir plus /ObjectCache if NULL.
+    // maxSizeBytes_ of 0 disables the cache (the default), least recently used entries are evicted above this.
+    virtual void SetObjectCache( const char* path_, unsigned long long maxSizeBytes_ ) = 0;
+
     // clean up temporary object files
     virtual void CleanObjectFiles() const = 0;
 
@@ -142,6 +201,16 @@ struct IRuntimeObjectSystem : public ITestBuildNotifier
     // returns the number of errors - 0 if all passed.
     virtual int TestBuildAllRuntimeHeaders(     ITestBuildNotifier* callback, bool bTestFileTracking ) = 0;
 
+    // Number of files of a project changed together by the test builds, so they are compiled in parallel
+    // (see SetMaxParallelCompiles) into one module and loaded and swapped once. Files of a batch which fails
+    // are then tested one by one. Defaults to 1, testing each file on its own.
+    virtual void SetTestBuildBatchSize( unsigned int numFiles_ ) = 0;
+
+    // Report of the result and compile, link, load and object swap times of each file written at the end of
+    // each test build, as JSON if path_ ends in .json and CSV otherwise. Files in a batch share its times.
+    // NULL or "" (the default) disables the report.
+    virtual void SetTestBuildReport( const char* path_ ) = 0;
+
     // FindFile - attempts to find the file in a source directory, if pFound not NULL returns if file found
     virtual FileSystemUtils::Path   FindFile( const FileSystemUtils::Path& input, bool* pFound = NULL ) = 0;
 
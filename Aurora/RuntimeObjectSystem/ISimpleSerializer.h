@@ -27,6 +27,9 @@
 
 
 #include "../RuntimeObjectSystem/ObjectInterface.h"
+#include <new>
+#include <string.h>
+#include <type_traits>
 
 
 #define SERIALIZE(prop) pSerializer->SerializeProperty(#prop, prop);
@@ -53,6 +56,82 @@ struct SerializedValue : ISerializedValue
 	const T value;
 };
 
+// Identifies the type of a serialized property so a serializer can detect a type change between reloads.
+// Arithmetic types have fixed ids so values can be converted between them, other types use a hash of the
+// compiler's name for the type, which is the same in every module built by the same compiler.
+typedef unsigned int SerializedTypeId;
+
+enum SerializedTypeIds
+{
+	SERIALIZEDTYPE_UNKNOWN = 0,
+	SERIALIZEDTYPE_BOOL,
+	SERIALIZEDTYPE_CHAR,
+	SERIALIZEDTYPE_SIGNED_CHAR,
+	SERIALIZEDTYPE_UNSIGNED_CHAR,
+	SERIALIZEDTYPE_SHORT,
+	SERIALIZEDTYPE_UNSIGNED_SHORT,
+	SERIALIZEDTYPE_INT,
+	SERIALIZEDTYPE_UNSIGNED_INT,
+	SERIALIZEDTYPE_LONG,
+	SERIALIZEDTYPE_UNSIGNED_LONG,
+	SERIALIZEDTYPE_LONG_LONG,
+	SERIALIZEDTYPE_UNSIGNED_LONG_LONG,
+	SERIALIZEDTYPE_FLOAT,
+	SERIALIZEDTYPE_DOUBLE,
+	SERIALIZEDTYPE_LONG_DOUBLE,
+	SERIALIZEDTYPE_ARITHMETIC_END,
+	SERIALIZEDTYPE_OBJECTID = SERIALIZEDTYPE_ARITHMETIC_END,
+	SERIALIZEDTYPE_POINTER_BIT = 0x40000000,	// set on ids of pointers and arrays of pointers, which are only valid within a process
+	SERIALIZEDTYPE_HASHED_BIT = 0x80000000	// set on ids from type name hashes
+};
+
+#ifdef _MSC_VER
+	#define RCCPP_FUNCTION_SIGNATURE __FUNCSIG__
+#else
+	#define RCCPP_FUNCTION_SIGNATURE __PRETTY_FUNCTION__
+#endif
+
+inline SerializedTypeId HashSerializedTypeName( const char* name_ )
+{
+	unsigned int hash = 2166136261u;
+	for( ; *name_; ++name_ )
+	{
+		hash ^= (unsigned char)*name_;
+		hash *= 16777619u;
+	}
+	return ( hash & ~(unsigned int)SERIALIZEDTYPE_POINTER_BIT ) | SERIALIZEDTYPE_HASHED_BIT;
+}
+
+template <typename T> struct SerializedType
+{
+	static SerializedTypeId Id()
+	{
+		// the function signature includes the name of T
+		static const SerializedTypeId id = HashSerializedTypeName( RCCPP_FUNCTION_SIGNATURE )
+			| ( std::is_pointer<typename std::remove_all_extents<T>::type>::value ? SERIALIZEDTYPE_POINTER_BIT : 0 );
+		return id;
+	}
+};
+
+#define RCCPP_SERIALIZEDTYPE( T, ID ) template<> struct SerializedType<T> { static SerializedTypeId Id() { return ID; } };
+RCCPP_SERIALIZEDTYPE( bool,					SERIALIZEDTYPE_BOOL )
+RCCPP_SERIALIZEDTYPE( char,					SERIALIZEDTYPE_CHAR )
+RCCPP_SERIALIZEDTYPE( signed char,			SERIALIZEDTYPE_SIGNED_CHAR )
+RCCPP_SERIALIZEDTYPE( unsigned char,		SERIALIZEDTYPE_UNSIGNED_CHAR )
+RCCPP_SERIALIZEDTYPE( short,				SERIALIZEDTYPE_SHORT )
+RCCPP_SERIALIZEDTYPE( unsigned short,		SERIALIZEDTYPE_UNSIGNED_SHORT )
+RCCPP_SERIALIZEDTYPE( int,					SERIALIZEDTYPE_INT )
+RCCPP_SERIALIZEDTYPE( unsigned int,			SERIALIZEDTYPE_UNSIGNED_INT )
+RCCPP_SERIALIZEDTYPE( long,					SERIALIZEDTYPE_LONG )
+RCCPP_SERIALIZEDTYPE( unsigned long,		SERIALIZEDTYPE_UNSIGNED_LONG )
+RCCPP_SERIALIZEDTYPE( long long,			SERIALIZEDTYPE_LONG_LONG )
+RCCPP_SERIALIZEDTYPE( unsigned long long,	SERIALIZEDTYPE_UNSIGNED_LONG_LONG )
+RCCPP_SERIALIZEDTYPE( float,				SERIALIZEDTYPE_FLOAT )
+RCCPP_SERIALIZEDTYPE( double,				SERIALIZEDTYPE_DOUBLE )
+RCCPP_SERIALIZEDTYPE( long double,			SERIALIZEDTYPE_LONG_DOUBLE )
+RCCPP_SERIALIZEDTYPE( ObjectId,				SERIALIZEDTYPE_OBJECTID )
+#undef RCCPP_SERIALIZEDTYPE
+
 
 struct ISimpleSerializer
 {
@@ -76,8 +155,41 @@ struct ISimpleSerializer
  
     virtual ~ISimpleSerializer( ) {}
 private:
+	template <typename T> bool SerializeTypedProperty(const char* propertyName, T& value, std::true_type isTriviallyCopyable);
+	template <typename T> bool SerializeTypedProperty(const char* propertyName, T& value, std::false_type isTriviallyCopyable);
+
+	// Implementations returning true store properties with their type, using SetTypedProperty and
+	// GetTypedProperty in place of SetISerializedValue and GetISerializedValue.
+	virtual bool SupportsTypedProperties() const
+	{
+		return false;
+	}
+
+	// Trivially copyable values are passed as pData_ and copied by the implementation,
+	// other values as pValue_ allocated with AllocateValue or new, as for SetISerializedValue.
+	virtual void SetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, const void* pData_, const ISerializedValue* pValue_ )
+	{
+		(void)propertyName; (void)type_; (void)size_; (void)pData_; (void)pValue_;
+	}
+
+	// Returns false if the property is missing, or stored as a different type which cannot be converted.
+	// Trivially copyable values are copied or converted into pData_, otherwise *ppValue_ is set.
+	virtual bool GetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, void* pData_, const ISerializedValue** ppValue_ ) const
+	{
+		(void)propertyName; (void)type_; (void)size_; (void)pData_; (void)ppValue_;
+		return false;
+	}
+
+	// Implementation may provide storage for values, which are then constructed in place.
+	// Returns NULL (default) for values to be allocated with new.
+	virtual void* AllocateValue( size_t size_, size_t alignment_ )
+	{
+		(void)size_; (void)alignment_;
+		return NULL;
+	}
+
 	// Implementation requires backing the following functions with keyed storage
-    // pValue should be deleted by implementation in destructor.
+    // pValue should be deleted by implementation in destructor, or only destroyed if from AllocateValue.
 	virtual void SetISerializedValue(const char* propertyName, const ISerializedValue* pValue) = 0;
 	virtual const ISerializedValue* GetISerializedValue(const char* propertyName) const = 0;
 
@@ -90,6 +202,11 @@ private:
 template <typename T>
 inline bool ISimpleSerializer::SerializeProperty(const char* propertyName, T& value)
 {
+	if( SupportsTypedProperties() )
+	{
+		return SerializeTypedProperty( propertyName, value, std::integral_constant<bool, std::is_trivially_copyable<T>::value>() );
+	}
+
 	if (IsLoading())
 	{
 		const SerializedValue<T>* pSV = static_cast<const SerializedValue<T>*>(GetISerializedValue(propertyName));
@@ -102,13 +219,44 @@ inline bool ISimpleSerializer::SerializeProperty(const char* propertyName, T& va
 	}
 	else
 	{
-		const SerializedValue<T>* pSv = new SerializedValue<T>(value);
+		void* pMemory = AllocateValue( sizeof( SerializedValue<T> ), alignof( SerializedValue<T> ) );
+		const SerializedValue<T>* pSv = pMemory ? new( pMemory ) SerializedValue<T>(value) : new SerializedValue<T>(value);
 		SetISerializedValue(propertyName, pSv);
 	}	
 
 	return true;
 }
 
+template <typename T>
+inline bool ISimpleSerializer::SerializeTypedProperty(const char* propertyName, T& value, std::true_type)
+{
+	if (IsLoading())
+	{
+		return GetTypedProperty( propertyName, SerializedType<T>::Id(), sizeof( T ), &value, NULL );
+	}
+	SetTypedProperty( propertyName, SerializedType<T>::Id(), sizeof( T ), &value, NULL );
+	return true;
+}
+
+template <typename T>
+inline bool ISimpleSerializer::SerializeTypedProperty(const char* propertyName, T& value, std::false_type)
+{
+	if (IsLoading())
+	{
+		const ISerializedValue* pValue = NULL;
+		if( !GetTypedProperty( propertyName, SerializedType<T>::Id(), sizeof( T ), NULL, &pValue ) || !pValue )
+		{
+			return false;
+		}
+		value = static_cast<const SerializedValue<T>*>( pValue )->value;
+		return true;
+	}
+	void* pMemory = AllocateValue( sizeof( SerializedValue<T> ), alignof( SerializedValue<T> ) );
+	const SerializedValue<T>* pSv = pMemory ? new( pMemory ) SerializedValue<T>(value) : new SerializedValue<T>(value);
+	SetTypedProperty( propertyName, SerializedType<T>::Id(), sizeof( T ), NULL, pSv );
+	return true;
+}
+
 template <typename T, size_t N>
 struct SerializedValueArray : ISerializedValue
 {
@@ -129,6 +277,17 @@ struct SerializedValueArray : ISerializedValue
 template <typename T, size_t N>
 inline bool ISimpleSerializer::SerializeProperty(const char* propertyName, T (&arrayIn)[N])
 {
+	if( SupportsTypedProperties() )
+	{
+		// arrays are copied as bytes, as SerializedValueArray does
+		if (IsLoading())
+		{
+			return GetTypedProperty( propertyName, SerializedType<T[N]>::Id(), sizeof( arrayIn ), arrayIn, NULL );
+		}
+		SetTypedProperty( propertyName, SerializedType<T[N]>::Id(), sizeof( arrayIn ), arrayIn, NULL );
+		return true;
+	}
+
 	if (IsLoading())
 	{
 		const SerializedValueArray<T,N>* pSV = static_cast<const SerializedValueArray<T,N>*>(GetISerializedValue(propertyName));
@@ -141,7 +300,8 @@ inline bool ISimpleSerializer::SerializeProperty(const char* propertyName, T (&a
 	}
 	else
 	{
-		const SerializedValueArray<T,N>* pSv = new SerializedValueArray<T,N>(arrayIn);
+		void* pMemory = AllocateValue( sizeof( SerializedValueArray<T,N> ), alignof( SerializedValueArray<T,N> ) );
+		const SerializedValueArray<T,N>* pSv = pMemory ? new( pMemory ) SerializedValueArray<T,N>(arrayIn) : new SerializedValueArray<T,N>(arrayIn);
 		SetISerializedValue(propertyName, pSv);
 	}	
 
@@ -21,6 +21,13 @@
 #include "../ObjectInterfacePerModule.h"
 #include "../IObject.h"
 #include "../IRuntimeObjectSystem.h"
+#include "../../RuntimeCompiler/FileSystemUtils.h"
+
+#include <thread>
+#include <algorithm>
+
+// objects per ObjectRange for parallel object swap, small enough to balance types with many objects
+static const PerTypeObjectId OBJECTS_PER_RANGE = 1024;
 
 
 #if RCCPP_ALLOCATOR_INTERFACE
@@ -82,28 +89,272 @@ IObjectConstructor* ObjectFactorySystem::GetConstructor( ConstructorId id ) cons
 	return 0;
 }
 
-void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
+ObjectFactorySystem::ProtectedObjectSwapper::ProtectedObjectSwapper()
+	: m_pLogger( 0 )
+	, m_pObjectFactorySystem( 0 )
+	, m_bTestSerialization( false )
+	, m_ProtectedPhase( PHASE_NONE )
 {
-	m_ProtectedPhase = PHASE_SERIALIZEOUT;
+	m_SerializerShards.push_back( &m_Serializer );
+}
 
-	// serialize all out
-	if( m_pLogger ) m_pLogger->LogInfo( "Serializing out from %d old constructors...\n", (int)m_ConstructorsOld.size());
+ObjectFactorySystem::ProtectedObjectSwapper::~ProtectedObjectSwapper()
+{
+	for( size_t i = 1; i < m_SerializerShards.size(); ++i )
+	{
+		delete m_SerializerShards[i];
+	}
+}
 
-	// use a temporary serializer in case there is an exception, so preserving any old state (if there is any)
-	m_Serializer.SetIsLoading( false );
-	for( size_t i = 0; i < m_ConstructorsOld.size(); ++i )
+void ObjectFactorySystem::ObjectSwapWorker::ProtectedFunc()
+{
+	for( size_t i = 0; i < m_pRanges->size(); ++i )
+	{
+		const ObjectRange& range = (*m_pRanges)[i];
+		IObjectConstructor* pConstructor = (*m_pConstructors)[ range.constructorIndex ];
+		if( SWAPTASK_SERIALIZE == m_Task )
+		{
+			for( PerTypeObjectId objId = range.begin; objId < range.end; ++objId )
+			{
+				IObject* pObject = pConstructor->GetConstructedObject( objId );
+				if( pObject )
+				{
+					m_pSerializer->Serialize( pObject );
+				}
+			}
+		}
+		else
+		{
+			// objects must be constructed in order, so a construct range covers all objects of the constructor
+			IObjectConstructor* pOldConstructor = (*m_pConstructorsOld)[ range.constructorIndex ];
+			for( PerTypeObjectId objId = range.begin; objId < range.end; ++objId )
+			{
+				if( pOldConstructor->GetConstructedObject( objId ) )
+				{
+					pConstructor->Construct();
+				}
+				else
+				{
+					pConstructor->ConstructNull();
+				}
+			}
+		}
+	}
+}
+
+static void RunObjectSwapWorker( IRuntimeObjectSystem* pRuntimeObjectSystem, RuntimeProtector* pWorker )
+{
+	pRuntimeObjectSystem->TryProtectedFunction( pWorker );
+}
+
+void ObjectFactorySystem::ProtectedObjectSwapper::CreateSerializerShards()
+{
+	unsigned int numThreads = 1;
+	const std::vector<bool>& parallelProjects = m_pObjectFactorySystem->m_ParallelObjectSwapProjects;
+	if( std::find( parallelProjects.begin(), parallelProjects.end(), true ) != parallelProjects.end() )
+	{
+		numThreads = m_pObjectFactorySystem->m_ObjectSwapThreadCount;
+		if( 0 == numThreads )
+		{
+			numThreads = std::max( std::thread::hardware_concurrency(), 1u );
+		}
+	}
+	while( m_SerializerShards.size() < numThreads )
+	{
+		m_SerializerShards.push_back( new ArenaSerializer );
+	}
+}
+
+void ObjectFactorySystem::ProtectedObjectSwapper::GetObjectRanges( const TConstructors& constructors_, std::vector<TObjectRanges>& shardRanges_ ) const
+{
+	size_t numShards = m_SerializerShards.size();
+	shardRanges_.assign( numShards, TObjectRanges() );
+	size_t shard = 0;
+	for( size_t i = 0; i < constructors_.size(); ++i )
+	{
+		if( !GetIsSwapped( i ) )
+		{
+			continue;
+		}
+		IObjectConstructor* pConstructor = constructors_[i];
+		PerTypeObjectId numObjects = pConstructor->GetNumberConstructedObjects();
+		if( 1 == numShards || !m_pObjectFactorySystem->GetParallelObjectSwap( pConstructor->GetProjectId() ) )
+		{
+			ObjectRange range = { i, 0, numObjects };
+			shardRanges_[0].push_back( range );
+			continue;
+		}
+		for( PerTypeObjectId begin = 0; begin < numObjects; begin += OBJECTS_PER_RANGE )
+		{
+			ObjectRange range = { i, begin, std::min( begin + OBJECTS_PER_RANGE, numObjects ) };
+			shardRanges_[ shard ].push_back( range );
+			shard = ( shard + 1 ) % numShards;
+		}
+	}
+}
+
+void ObjectFactorySystem::ProtectedObjectSwapper::LogSchemaChanges( const TConstructors& constructors_ ) const
+{
+	if( !m_pLogger )
+	{
+		return;
+	}
+	for( size_t i = 0; i < constructors_.size(); ++i )
+	{
+		if( !GetIsSwapped( i ) )
+		{
+			continue;
+		}
+		ArenaSerializer::SchemaChanges total = { false, 0, 0 };
+		for( size_t shard = 0; shard < m_SerializerShards.size(); ++shard )
+		{
+			ArenaSerializer::SchemaChanges changes = m_SerializerShards[ shard ]->GetSchemaChanges( constructors_[i]->GetConstructorId() );
+			total.bSchemaChanged = total.bSchemaChanged || changes.bSchemaChanged;
+			total.numConverted  += changes.numConverted;
+			total.numSkipped    += changes.numSkipped;
+		}
+		if( total.numSkipped )
+		{
+			m_pLogger->LogWarning( "Type %s changed serialized property types, %d values converted and %d skipped.\n",
+				constructors_[i]->GetName(), (int)total.numConverted, (int)total.numSkipped );
+		}
+		else if( total.numConverted )
+		{
+			m_pLogger->LogInfo( "Type %s changed serialized property types, %d values converted.\n",
+				constructors_[i]->GetName(), (int)total.numConverted );
+		}
+		else if( total.bSchemaChanged )
+		{
+			m_pLogger->LogInfo( "Type %s changed serialized properties.\n", constructors_[i]->GetName() );
+		}
+	}
+}
+
+void ObjectFactorySystem::ProtectedObjectSwapper::SetSerializersLoading( bool bLoading_ )
+{
+	for( size_t i = 0; i < m_SerializerShards.size(); ++i )
+	{
+		m_SerializerShards[i]->SetIsLoading( bLoading_ );
+	}
+}
+
+bool ObjectFactorySystem::ProtectedObjectSwapper::RunShards( SwapTask task_, const TConstructors& constructors_, const std::vector<TObjectRanges>& shardRanges_, bool bUseThreads_ )
+{
+	std::vector<ObjectSwapWorker> workers( shardRanges_.size() );
+	for( size_t i = 0; i < workers.size(); ++i )
+	{
+		workers[i].m_Task             = task_;
+		workers[i].m_pConstructors    = &constructors_;
+		workers[i].m_pConstructorsOld = &m_ConstructorsOld;
+		workers[i].m_pRanges          = &shardRanges_[i];
+		workers[i].m_pSerializer      = m_SerializerShards[i];
+	}
+
+	if( !bUseThreads_ )
+	{
+		for( size_t i = 0; i < workers.size(); ++i )
+		{
+			workers[i].ProtectedFunc();
+		}
+		return true;
+	}
+
+	// shard 0 runs on this thread, each worker thread has its own protector
+	IRuntimeObjectSystem* pRuntimeObjectSystem = m_pObjectFactorySystem->m_pRuntimeObjectSystem;
+	std::vector<std::thread> threads;
+	for( size_t i = 1; i < workers.size(); ++i )
+	{
+		if( workers[i].m_pRanges->size() )
+		{
+			threads.push_back( std::thread( RunObjectSwapWorker, pRuntimeObjectSystem, &workers[i] ) );
+		}
+	}
+	pRuntimeObjectSystem->TryProtectedFunction( &workers[0] );
+	for( size_t i = 0; i < threads.size(); ++i )
+	{
+		threads[i].join();
+	}
+
+	for( size_t i = 0; i < workers.size(); ++i )
 	{
-		IObjectConstructor* pOldConstructor = m_ConstructorsOld[i];
-		size_t numObjects = pOldConstructor->GetNumberConstructedObjects();
-		for( size_t j = 0; j < numObjects; ++j )
+		if( workers[i].HasHadException() )
 		{
-			IObject* pOldObject = pOldConstructor->GetConstructedObject( j );
-			if (pOldObject)
+			ExceptionInfo = workers[i].ExceptionInfo;
+			m_bHashadException = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ObjectFactorySystem::ProtectedObjectSwapper::SerializeObjects( const TConstructors& constructors_, bool bUseThreads_ )
+{
+	std::vector<TObjectRanges> shardRanges;
+	GetObjectRanges( constructors_, shardRanges );
+	return RunShards( SWAPTASK_SERIALIZE, constructors_, shardRanges, bUseThreads_ );
+}
+
+size_t ObjectFactorySystem::ProtectedObjectSwapper::CalculateConstructorsToSwap()
+{
+	if( !m_pObjectFactorySystem->m_bIncrementalObjectSwap )
+	{
+		m_ConstructorsToSwap.assign( m_ConstructorsOld.size(), true );
+		return m_ConstructorsOld.size();
+	}
+
+	// only constructors being replaced and those registered as dependent on them
+	m_ConstructorsToSwap.assign( m_ConstructorsOld.size(), false );
+	size_t numToSwap = 0;
+	const TSwapDependencies& dependencies = m_pObjectFactorySystem->m_SwapDependencies;
+	for( size_t i = 0; i < m_ConstructorsToAdd.size(); ++i )
+	{
+		IObjectConstructor* pConstructor = m_ConstructorsToAdd[i];
+		ConstructorId id = m_pObjectFactorySystem->GetConstructorId( pConstructor->GetName() );
+		if( id >= m_ConstructorsOld.size() || m_ConstructorsOld[ id ] == pConstructor )
+		{
+			continue;
+		}
+		if( !m_ConstructorsToSwap[ id ] )
+		{
+			m_ConstructorsToSwap[ id ] = true;
+			++numToSwap;
+		}
+
+		std::pair<TSwapDependencies::const_iterator,TSwapDependencies::const_iterator> range = dependencies.equal_range( pConstructor->GetName() );
+		for( TSwapDependencies::const_iterator it = range.first; it != range.second; ++it )
+		{
+			ConstructorId dependentId = m_pObjectFactorySystem->GetConstructorId( it->second.c_str() );
+			if( dependentId < m_ConstructorsOld.size() && !m_ConstructorsToSwap[ dependentId ] )
 			{
-				m_Serializer.Serialize( pOldObject );
-			}		
+				m_ConstructorsToSwap[ dependentId ] = true;
+				++numToSwap;
+			}
 		}
 	}
+	return numToSwap;
+}
+
+void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
+{
+	m_ProtectedPhase = PHASE_SERIALIZEOUT;
+	TimePoint phaseStart = GetTimeNow();
+
+	size_t numToSwap = CalculateConstructorsToSwap();
+	CreateSerializerShards();
+
+	// serialize out objects being swapped
+	if( m_pLogger ) m_pLogger->LogInfo( "Serializing out from %d of %d old constructors...\n", (int)numToSwap, (int)m_ConstructorsOld.size());
+	if( m_pLogger && m_SerializerShards.size() > 1 ) m_pLogger->LogInfo( "Using %d threads for parallel object swap.\n", (int)m_SerializerShards.size());
+
+	// use a temporary serializer in case there is an exception, so preserving any old state (if there is any)
+	SetSerializersLoading( false );
+	if( !SerializeObjects( m_ConstructorsOld, true ) )
+	{
+		return;
+	}
+	m_Timings.serializeOut = GetSecondsSince( phaseStart );
+	phaseStart = GetTimeNow();
+
 	// swap serializer
 	if( m_pLogger ) m_pLogger->LogInfo( "Swapping in and creating objects for %d new constructors...\n", (int)m_ConstructorsToAdd.size());
 
@@ -111,6 +362,8 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 	TConstructors& constructorsNew = m_pObjectFactorySystem->m_Constructors;
 
 	//swap old constructors with new ones and create new objects
+	std::vector<TObjectRanges> constructRanges( m_SerializerShards.size() );
+	size_t constructShard = 0;
 	for( size_t i = 0; i < m_ConstructorsToAdd.size(); ++i )
 	{
 		IObjectConstructor* pConstructor = m_ConstructorsToAdd[i];
@@ -129,6 +382,15 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 			// replace and construct
 			pConstructor->SetConstructorId( pOldConstructor->GetConstructorId() );
 			constructorsNew[ pConstructor->GetConstructorId() ] = pConstructor;
+			m_ConstructorsReplaced.push_back( pOldConstructor );
+			if( constructRanges.size() > 1 && m_pObjectFactorySystem->GetParallelObjectSwap( pConstructor->GetProjectId() ) )
+			{
+				// construct on a worker thread after all constructors are swapped
+				ObjectRange range = { pConstructor->GetConstructorId(), 0, pOldConstructor->GetNumberConstructedObjects() };
+				constructRanges[ constructShard ].push_back( range );
+				constructShard = ( constructShard + 1 ) % constructRanges.size();
+				continue;
+			}
 			for( PerTypeObjectId objId = 0; objId < pOldConstructor->GetNumberConstructedObjects(); ++ objId )
 			{
 				// create new object
@@ -141,7 +403,6 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 					pConstructor->ConstructNull();
 				}
 			}
-			m_ConstructorsReplaced.push_back( pOldConstructor );
 		}
 		else
 		{
@@ -152,24 +413,27 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 		}
 	}
 
+	if( !RunShards( SWAPTASK_CONSTRUCT, constructorsNew, constructRanges, true ) )
+	{
+		return;
+	}
+
 	if( m_pLogger ) m_pLogger->LogInfo( "Serialising in...\n");
 
+	m_Timings.constructNew = GetSecondsSince( phaseStart );
+	phaseStart = GetTimeNow();
+
 	//serialize back
 	m_ProtectedPhase = PHASE_SERIALIZEIN;
-	m_Serializer.SetIsLoading( true );
-	for( size_t i = 0; i < constructorsNew.size(); ++i )
+	SetSerializersLoading( true );
+	if( !SerializeObjects( constructorsNew, true ) )
 	{
-		IObjectConstructor* pConstructor = constructorsNew[i];
-		for( PerTypeObjectId objId = 0; objId < pConstructor->GetNumberConstructedObjects(); ++ objId )
-		{
-			// Serialize new object
-			IObject* pObject = pConstructor->GetConstructedObject( objId );
-			if (pObject)
-			{
-				m_Serializer.Serialize( pObject );
-			}
-		}
+		return;
 	}
+	LogSchemaChanges( constructorsNew );
+
+    m_Timings.serializeIn = GetSecondsSince( phaseStart );
+    phaseStart = GetTimeNow();
 
     // auto construct singletons
     // now in 2 phases - construct then init
@@ -190,6 +454,9 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 	}
 
 
+	m_Timings.autoConstructSingletons = GetSecondsSince( phaseStart );
+	phaseStart = GetTimeNow();
+
 	// Do a second pass, initializing objects now that they've all been serialized
     // and testing serialization if required
 	m_ProtectedPhase = PHASE_INITANDSERIALIZEOUTTEST;
@@ -202,8 +469,14 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 	    if( m_pLogger ) m_pLogger->LogInfo( "Initialising...\n");
     }
 
+	ArenaSerializer testSerializer;
+	testSerializer.SetIsLoading( false );
 	for( size_t i = 0; i < constructorsNew.size(); ++i )
 	{
+		if( !GetIsSwapped( i ) && !bSingletonConstructed[i] )
+		{
+			continue;
+		}
 		IObjectConstructor* pConstructor = constructorsNew[i];
 		for( PerTypeObjectId objId = 0; objId < pConstructor->GetNumberConstructedObjects(); ++ objId )
 		{
@@ -216,14 +489,15 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 				if( m_bTestSerialization && ( m_ConstructorsOld.size() <= i || m_ConstructorsOld[ i ] != constructorsNew[ i ] ) )
 				{
 					//test serialize out for all new objects, we assume old objects are OK.
-					SimpleSerializer tempSerializer;
-					tempSerializer.SetIsLoading( false );
-					tempSerializer.Serialize( pObject );
+					testSerializer.Clear();
+					testSerializer.Serialize( pObject );
 				}
 			}
 		}
 	}
 
+	m_Timings.initAndSerializeTest = GetSecondsSince( phaseStart );
+	phaseStart = GetTimeNow();
 	m_ProtectedPhase = PHASE_DELETEOLD;
 	//delete old objects which have been replaced
 	for( size_t i = 0; i < m_ConstructorsOld.size(); ++i )
@@ -247,6 +521,7 @@ void ObjectFactorySystem::ProtectedObjectSwapper::ProtectedFunc()
 			assert( 0 == pOldConstructor->GetNumberConstructedObjects() );
 		}
 	}
+	m_Timings.deleteOld = GetSecondsSince( phaseStart );
 }
 
 bool ObjectFactorySystem::HandleRedoUndo( const TConstructors& constructors )
@@ -275,6 +550,7 @@ bool ObjectFactorySystem::HandleRedoUndo( const TConstructors& constructors )
 
 void ObjectFactorySystem::AddConstructors( IAUDynArray<IObjectConstructor*> &constructors )
 {
+	m_LastObjectSwapTimings = ObjectSwapTimings();
 	if( constructors.Size() == 0 )
 	{
 		if( m_pLogger ) m_pLogger->LogInfo( "ObjectFactorySystem::AddConstructors() called with no constructors.\n" );
@@ -287,6 +563,7 @@ void ObjectFactorySystem::AddConstructors( IAUDynArray<IObjectConstructor*> &con
 		while( RedoObjectConstructorChange() ) {}
 	}
 
+	TimePoint startTime = GetTimeNow();
 	ProtectedObjectSwapper swapper;
 	swapper.m_ConstructorsToAdd.assign( &constructors[0], &constructors[constructors.Size() - 1] + 1 );
 	swapper.m_ConstructorsOld = m_Constructors;
@@ -299,6 +576,8 @@ void ObjectFactorySystem::AddConstructors( IAUDynArray<IObjectConstructor*> &con
     m_pRuntimeObjectSystem->TryProtectedFunction( &swapper );
 
 	CompleteConstructorSwap( swapper );
+	m_LastObjectSwapTimings = swapper.m_Timings;
+	m_LastObjectSwapTimings.total = GetSecondsSince( startTime );
 
 	if( m_HistoryMaxSize )
 	{
@@ -355,24 +634,16 @@ void ObjectFactorySystem::CompleteConstructorSwap( ProtectedObjectSwapper& swapp
 		if( PHASE_SERIALIZEOUT != swapper.m_ProtectedPhase )
 		{
 			//serialize back with old objects - could cause exception which isn't handled, but hopefully not.
-			swapper.m_Serializer.SetIsLoading( true );
-			for( size_t i = 0; i < m_Constructors.size(); ++i )
-			{
-				IObjectConstructor* pConstructor = m_Constructors[i];
-				for( PerTypeObjectId objId = 0; objId < pConstructor->GetNumberConstructedObjects(); ++ objId )
-				{
-					// Iserialize new object
-					IObject* pObject = pConstructor->GetConstructedObject( objId );
-					if (pObject)
-					{
-						swapper.m_Serializer.Serialize( pObject );
-					}			
-				}
-			}
+			swapper.SetSerializersLoading( true );
+			swapper.SerializeObjects( m_Constructors, false );
 
 			// Do a second pass, initializing objects now that they've all been serialized
 			for( size_t i = 0; i < m_Constructors.size(); ++i )
 			{
+				if( !swapper.GetIsSwapped( i ) )
+				{
+					continue;
+				}
 				IObjectConstructor* pConstructor = m_Constructors[i];
 				for( PerTypeObjectId objId = 0; objId < pConstructor->GetNumberConstructedObjects(); ++ objId )
 				{
@@ -425,6 +696,214 @@ IObject* ObjectFactorySystem::GetObject( ObjectId id ) const
 	return 0;
 }
 
+bool ObjectFactorySystem::GetIsConstructorInUse( IObjectConstructor* pConstructor_ ) const
+{
+	ConstructorId id = pConstructor_->GetConstructorId();
+	if( id < m_Constructors.size() && m_Constructors[ id ] == pConstructor_ )
+	{
+		return true;
+	}
+	for( size_t i = 0; i < m_HistoryConstructors.size(); ++i )
+	{
+		const HistoryPoint& historyPoint = m_HistoryConstructors[i];
+		if( std::find( historyPoint.before.begin(), historyPoint.before.end(), pConstructor_ ) != historyPoint.before.end()
+			|| std::find( historyPoint.after.begin(), historyPoint.after.end(), pConstructor_ ) != historyPoint.after.end() )
+		{
+			return true;
+		}
+	}
+	for( PerTypeObjectId objId = 0; objId < pConstructor_->GetNumberConstructedObjects(); ++objId )
+	{
+		if( pConstructor_->GetConstructedObject( objId ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ObjectFactorySystem::AddSwapDependency( const char* dependentType_, const char* dependencyType_ )
+{
+	std::pair<TSwapDependencies::iterator,TSwapDependencies::iterator> range = m_SwapDependencies.equal_range( dependencyType_ );
+	for( TSwapDependencies::iterator it = range.first; it != range.second; ++it )
+	{
+		if( it->second == dependentType_ )
+		{
+			return;
+		}
+	}
+	m_SwapDependencies.insert( std::make_pair( std::string( dependencyType_ ), std::string( dependentType_ ) ) );
+}
+
+void ObjectFactorySystem::RemoveSwapDependency( const char* dependentType_, const char* dependencyType_ )
+{
+	std::pair<TSwapDependencies::iterator,TSwapDependencies::iterator> range = m_SwapDependencies.equal_range( dependencyType_ );
+	for( TSwapDependencies::iterator it = range.first; it != range.second; ++it )
+	{
+		if( it->second == dependentType_ )
+		{
+			m_SwapDependencies.erase( it );
+			return;
+		}
+	}
+}
+
+bool ObjectFactorySystem::SaveSnapshot( const char* filename_ )
+{
+	TimePoint start = GetTimeNow();
+	ArenaSerializer serializer;
+	serializer.SetIsLoading( false );
+	std::vector<const char*> typeNames( m_Constructors.size() );
+	size_t numObjects = 0;
+	for( size_t i = 0; i < m_Constructors.size(); ++i )
+	{
+		IObjectConstructor* pConstructor = m_Constructors[i];
+		typeNames[i] = pConstructor->GetName();
+		for( PerTypeObjectId id = 0; id < pConstructor->GetNumberConstructedObjects(); ++id )
+		{
+			IObject* pObject = pConstructor->GetConstructedObject( id );
+			if( pObject )
+			{
+				serializer.Serialize( pObject );
+				++numObjects;
+			}
+		}
+	}
+	serializer.SetIsLoading( true );
+
+	// write to a temporary file so a failed save leaves any previous snapshot intact
+	FileSystemUtils::Path path( filename_ );
+	FileSystemUtils::Path tempPath( path.m_string + ".tmp" );
+	FILE* pFile = FileSystemUtils::fopen( tempPath, "wb" );
+	if( !pFile )
+	{
+		if( m_pLogger ) m_pLogger->LogError( "Could not open %s to save snapshot.\n", tempPath.c_str() );
+		return false;
+	}
+	size_t numSkipped = 0;
+	bool bOk = serializer.SaveSnapshot( pFile, typeNames, numSkipped );
+	bOk = 0 == fclose( pFile ) && bOk;
+	if( bOk && path.Exists() )
+	{
+		bOk = path.Remove();
+	}
+	bOk = bOk && tempPath.Rename( path );
+	if( !bOk )
+	{
+		if( m_pLogger ) m_pLogger->LogError( "Failed to save snapshot %s.\n", filename_ );
+		tempPath.Remove();
+		return false;
+	}
+
+	if( m_pLogger ) m_pLogger->LogInfo( "Saved snapshot of %d objects to %s in %f seconds.\n", (int)numObjects, filename_, GetSecondsSince( start ) );
+	if( m_pLogger && numSkipped ) m_pLogger->LogWarning( "Snapshot skipped %d pointer or non trivially copyable properties.\n", (int)numSkipped );
+	return true;
+}
+
+bool ObjectFactorySystem::LoadSnapshot( const char* filename_ )
+{
+	TimePoint start = GetTimeNow();
+	FileSystemUtils::MappedFile file( filename_ );
+	if( !file.GetData() )
+	{
+		if( m_pLogger ) m_pLogger->LogError( "Could not open snapshot %s.\n", filename_ );
+		return false;
+	}
+
+	ArenaSerializer serializer;
+	std::vector<const char*> snapshotTypes;
+	std::vector<ObjectId> objectIds;
+	bool bOk = serializer.OpenSnapshot( file.GetData(), file.GetSize(), snapshotTypes );
+	std::vector<ConstructorId> constructorIds( snapshotTypes.size(), InvalidId );
+	for( size_t i = 0; bOk && i < snapshotTypes.size(); ++i )
+	{
+		constructorIds[i] = GetConstructorId( snapshotTypes[i] );
+		if( InvalidId == constructorIds[i] )
+		{
+			if( m_pLogger ) m_pLogger->LogWarning( "Snapshot type %s not found, not restoring its objects.\n", snapshotTypes[i] );
+		}
+	}
+	bOk = bOk && serializer.LoadSnapshot( constructorIds, objectIds );
+	if( !bOk )
+	{
+		if( m_pLogger ) m_pLogger->LogError( "Snapshot %s is invalid.\n", filename_ );
+		return false;
+	}
+	serializer.SetIsLoading( true );
+
+	// construct all objects before serializing in, so ObjectIds between them are valid
+	std::vector<IObject*> objects;
+	std::vector<bool> bConstructed;
+	size_t numNotRestored = 0;
+	size_t begin = 0;
+	while( begin < objectIds.size() )
+	{
+		ConstructorId constructorId = objectIds[ begin ].m_ConstructorId;
+		size_t end = begin;
+		while( end < objectIds.size() && objectIds[ end ].m_ConstructorId == constructorId )
+		{
+			++end;
+		}
+
+		IObjectConstructor* pConstructor = m_Constructors[ constructorId ];
+		bool bHasObjects = false;
+		for( PerTypeObjectId id = 0; id < pConstructor->GetNumberConstructedObjects() && !bHasObjects; ++id )
+		{
+			bHasObjects = 0 != pConstructor->GetConstructedObject( id );
+		}
+
+		if( !bHasObjects )
+		{
+			// objects are constructed in PerTypeObjectId order, with null objects for gaps
+			pConstructor->ClearIfAllDeleted();
+			PerTypeObjectId nextId = 0;
+			for( size_t i = begin; i < end; ++i )
+			{
+				for( ; nextId < objectIds[i].m_PerTypeId; ++nextId )
+				{
+					pConstructor->ConstructNull();
+				}
+				objects.push_back( pConstructor->Construct() );
+				bConstructed.push_back( true );
+				++nextId;
+			}
+		}
+		else
+		{
+			for( size_t i = begin; i < end; ++i )
+			{
+				IObject* pObject = pConstructor->GetConstructedObject( objectIds[i].m_PerTypeId );
+				if( pObject )
+				{
+					objects.push_back( pObject );
+					bConstructed.push_back( false );
+				}
+				else
+				{
+					++numNotRestored;
+				}
+			}
+		}
+		begin = end;
+	}
+
+	for( size_t i = 0; i < objects.size(); ++i )
+	{
+		serializer.Serialize( objects[i] );
+	}
+	for( size_t i = 0; i < objects.size(); ++i )
+	{
+		if( bConstructed[i] )
+		{
+			objects[i]->Init( false );
+		}
+	}
+
+	if( m_pLogger ) m_pLogger->LogInfo( "Restored %d objects from snapshot %s in %f seconds.\n", (int)objects.size(), filename_, GetSecondsSince( start ) );
+	if( m_pLogger && numNotRestored ) m_pLogger->LogWarning( "Snapshot had %d objects of types with live objects which were not restored.\n", (int)numNotRestored );
+	return true;
+}
+
 void ObjectFactorySystem::AddListener(IObjectFactoryListener* pListener)
 {
 	m_Listeners.insert(pListener);
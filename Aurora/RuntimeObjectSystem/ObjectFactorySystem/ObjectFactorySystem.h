@@ -21,8 +21,9 @@
 #define OBJECTFACTORYSYSTEM_INCLUDED
 
 #include "../IObjectFactorySystem.h"
-#include "../SimpleSerializer/SimpleSerializer.h"
+#include "../SimpleSerializer/ArenaSerializer.h"
 #include "../RuntimeProtector.h"
+#include "../../RuntimeCompiler/CompileTimings.h"
 #include <map>
 #include <string>
 #include <set>
@@ -51,6 +52,8 @@ public:
 		, m_pAllocator( &m_DefaultAllocator )
 #endif
         , m_bTestSerialization( true )
+        , m_bIncrementalObjectSwap( false )
+        , m_ObjectSwapThreadCount( 0 )
 		, m_HistoryMaxSize( 0 )
 		, m_HistoryCurrentLocation( 0 )
  	{
@@ -73,6 +76,7 @@ public:
 	virtual void AddConstructors(IAUDynArray<IObjectConstructor*> &constructors);
 	virtual void GetAll(IAUDynArray<IObjectConstructor*> &constructors) const;
 	virtual IObject* GetObject( ObjectId id ) const;
+	virtual bool GetIsConstructorInUse( IObjectConstructor* pConstructor_ ) const;
 
 	virtual void AddListener(IObjectFactoryListener* pListener);
 	virtual void RemoveListener(IObjectFactoryListener* pListener);
@@ -99,11 +103,51 @@ public:
 	virtual bool				RedoObjectConstructorChange();
 	virtual int					GetObjectContstructorHistoryLocation();
 
+	virtual const ObjectSwapTimings& GetLastObjectSwapTimings() const
+	{
+		return m_LastObjectSwapTimings;
+	}
+
+	virtual void SetIncrementalObjectSwap( bool bIncremental )
+	{
+		m_bIncrementalObjectSwap = bIncremental;
+	}
+	virtual bool GetIncrementalObjectSwap() const
+	{
+		return m_bIncrementalObjectSwap;
+	}
+	virtual void AddSwapDependency( const char* dependentType_, const char* dependencyType_ );
+	virtual void RemoveSwapDependency( const char* dependentType_, const char* dependencyType_ );
+
+	virtual void SetParallelObjectSwap( bool bParallel_, unsigned short projectId_ )
+	{
+		if( projectId_ >= m_ParallelObjectSwapProjects.size() )
+		{
+			m_ParallelObjectSwapProjects.resize( projectId_ + 1, false );
+		}
+		m_ParallelObjectSwapProjects[ projectId_ ] = bParallel_;
+	}
+	virtual bool GetParallelObjectSwap( unsigned short projectId_ ) const
+	{
+		return projectId_ < m_ParallelObjectSwapProjects.size() && m_ParallelObjectSwapProjects[ projectId_ ];
+	}
+	virtual void SetObjectSwapThreadCount( unsigned int numThreads_ )
+	{
+		m_ObjectSwapThreadCount = numThreads_;
+	}
+	virtual unsigned int GetObjectSwapThreadCount() const
+	{
+		return m_ObjectSwapThreadCount;
+	}
+	virtual bool SaveSnapshot( const char* filename_ );
+	virtual bool LoadSnapshot( const char* filename_ );
+
 
 private:
 	typedef std::map<std::string,ConstructorId> CONSTRUCTORMAP;
 	typedef std::set<IObjectFactoryListener*>	TObjectFactoryListeners;
 	typedef std::vector<IObjectConstructor*>	TConstructors;
+	typedef std::multimap<std::string,std::string> TSwapDependencies; // dependency type to dependent types
 
 	CONSTRUCTORMAP 						m_ConstructorIds;
 	TConstructors 						m_Constructors;
@@ -115,6 +159,11 @@ private:
 	IObjectAllocator*					m_pAllocator;
 #endif
 	bool                                m_bTestSerialization;
+	bool                                m_bIncrementalObjectSwap;
+	TSwapDependencies                   m_SwapDependencies;
+	std::vector<bool>                   m_ParallelObjectSwapProjects;
+	unsigned int                        m_ObjectSwapThreadCount;
+	ObjectSwapTimings					m_LastObjectSwapTimings;
 
 	// History
 	int									m_HistoryMaxSize;
@@ -139,23 +188,80 @@ private:
 		PHASE_DELETEOLD,
 	};
 
+	// range of objects of one constructor, the unit of work for parallel object swap phases
+	struct ObjectRange
+	{
+		size_t								constructorIndex;
+		PerTypeObjectId						begin;
+		PerTypeObjectId						end;
+	};
+	typedef std::vector<ObjectRange>		TObjectRanges;
+
+	enum SwapTask
+	{
+		SWAPTASK_SERIALIZE,
+		SWAPTASK_CONSTRUCT,
+	};
+
+	// processes one shard of a parallel object swap phase, protected per thread
+	struct ObjectSwapWorker : public RuntimeProtector
+	{
+		SwapTask							m_Task;
+		const TConstructors*				m_pConstructors;
+		const TConstructors*				m_pConstructorsOld;	// for SWAPTASK_CONSTRUCT
+		const TObjectRanges*				m_pRanges;
+		ArenaSerializer*					m_pSerializer;		// for SWAPTASK_SERIALIZE
+
+		// RuntimeProtector implementation
+		virtual void ProtectedFunc();
+	};
+
 	// temp data needed during object swap
 	struct ProtectedObjectSwapper:  public RuntimeProtector
 	{
+		ProtectedObjectSwapper();
+		~ProtectedObjectSwapper();
+
 		TConstructors						m_ConstructorsToAdd;
 		TConstructors						m_ConstructorsOld;
 		TConstructors						m_ConstructorsReplaced;
-		SimpleSerializer					m_Serializer;
+		ArenaSerializer						m_Serializer;
 		ICompilerLogger*					m_pLogger;
 		ObjectFactorySystem*				m_pObjectFactorySystem;
 		bool								m_bTestSerialization;
 
 		ProtectedPhase						m_ProtectedPhase;
+		ObjectSwapTimings					m_Timings;
+
+		// flag per old ConstructorId of whether its objects are swapped, constructors
+		// added with new ids are always swapped.
+		std::vector<bool>					m_ConstructorsToSwap;
+		bool GetIsSwapped( size_t id_ ) const
+		{
+			return id_ >= m_ConstructorsToSwap.size() || m_ConstructorsToSwap[ id_ ];
+		}
+		size_t CalculateConstructorsToSwap();
+
+		// serializers for parallel object swap, shard 0 is m_Serializer and is used by the calling thread.
+		// objects are assigned to shards by ObjectRange, which is identical for serializing out and in.
+		std::vector<ArenaSerializer*>		m_SerializerShards;
+		void CreateSerializerShards();
+		void GetObjectRanges( const TConstructors& constructors_, std::vector<TObjectRanges>& shardRanges_ ) const;
+		void SetSerializersLoading( bool bLoading_ );
+
+		// processes the ranges of each shard on its own thread, serially if bUseThreads_ is false.
+		// returns false if there was an exception.
+		bool RunShards( SwapTask task_, const TConstructors& constructors_, const std::vector<TObjectRanges>& shardRanges_, bool bUseThreads_ );
+		bool SerializeObjects( const TConstructors& constructors_, bool bUseThreads_ );
+
+		// logs types whose serialized properties changed type since they were serialized out
+		void LogSchemaChanges( const TConstructors& constructors_ ) const;
 
 		// RuntimeProtector implementation
 		virtual void ProtectedFunc();
 	};
 	friend struct ProtectedObjectSwapper;
+	friend struct ObjectSwapWorker;
 
 	void CompleteConstructorSwap( ProtectedObjectSwapper& swapper );
 };
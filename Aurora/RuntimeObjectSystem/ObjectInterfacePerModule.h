@@ -105,6 +105,10 @@ public:
         , m_bIsAutoConstructSingleton(  bIsAutoConstructSingleton )
 		, m_pModuleInterface(0)
         , m_Project(0)
+#if !RCCPP_ALLOCATOR_INTERFACE
+		, m_NumSlabObjects(0)
+		, m_ConstructingId(InvalidId)
+#endif
 #ifndef RCCPPOFF
 		, m_pRuntimeTrackingList(pRuntimeTrackingList_)
 #endif
@@ -123,6 +127,50 @@ public:
 		m_Id = InvalidId;
 	}
 
+#if !RCCPP_ALLOCATOR_INTERFACE
+	~TObjectConstructorConcrete()
+	{
+		for( size_t i = 0; i < m_SlabChunks.size(); ++i )
+		{
+			FreeChunk( m_SlabChunks[i] );
+		}
+	}
+
+	// Objects are placed in fixed size chunks at the slot of their PerTypeObjectId, so slots are
+	// reused with ids from m_FreeIds and objects are in id order in memory. Chunks are only freed
+	// when no objects remain. Only Construct() may allocate, as it sets the id.
+	void* AllocateSlot( size_t size )
+	{
+		AU_ASSERT( size == sizeof( T ) && InvalidId != m_ConstructingId );
+		size_t chunk = m_ConstructingId / GetObjectsPerChunk();
+		if( chunk >= m_SlabChunks.size() )
+		{
+			m_SlabChunks.resize( chunk + 1, 0 );
+		}
+		if( !m_SlabChunks[ chunk ] )
+		{
+			m_SlabChunks[ chunk ] = AllocateChunk( GetObjectsPerChunk() * sizeof( T ) );
+		}
+		++m_NumSlabObjects;
+		return m_SlabChunks[ chunk ] + ( m_ConstructingId % GetObjectsPerChunk() ) * sizeof( T );
+	}
+
+	// called after the object is destroyed, so after DeRegister
+	void FreeSlot( void* p )
+	{
+		(void)p;
+		--m_NumSlabObjects;
+		if( 0 == m_NumSlabObjects )
+		{
+			for( size_t i = 0; i < m_SlabChunks.size(); ++i )
+			{
+				FreeChunk( m_SlabChunks[i] );
+			}
+			m_SlabChunks.clear();
+		}
+	}
+#endif
+
 #if RCCPP_ALLOCATOR_INTERFACE
 	IObjectAllocator* GetAllocator() const
 	{
@@ -146,7 +194,7 @@ public:
 		{
 			PerTypeObjectId id = m_ConstructedObjects.size();
 
-			pT = new T();
+			pT = ConstructWithId( id );
 			pT->SetPerTypeId( id );
 			m_ConstructedObjects.push_back( pT );
 		}
@@ -154,7 +202,7 @@ public:
 		{
 			PerTypeObjectId id = m_FreeIds.back();
 			m_FreeIds.pop_back();
-			pT = new T();
+			pT = ConstructWithId( id );
 			pT->SetPerTypeId( id );
 			AU_ASSERT( 0 == m_ConstructedObjects[ id ] );
 			m_ConstructedObjects[ id ] = pT;
@@ -289,6 +337,48 @@ public:
 	}
 
 private:
+#if RCCPP_ALLOCATOR_INTERFACE
+	T* ConstructWithId( PerTypeObjectId id )
+	{
+		(void)id;
+		return new T();
+	}
+#else
+	T* ConstructWithId( PerTypeObjectId id )
+	{
+		m_ConstructingId = id;
+		T* pT = new T();
+		m_ConstructingId = InvalidId;
+		return pT;
+	}
+
+	static size_t GetObjectsPerChunk()
+	{
+		const size_t chunkSize = 16 * 1024;
+		return sizeof( T ) < chunkSize ? chunkSize / sizeof( T ) : 1;
+	}
+	static char* AllocateChunk( size_t size )
+	{
+		size_t align = __alignof( T );
+#ifdef _WIN32
+		return (char*)_aligned_malloc( size, align );
+#else
+		void* pRet;
+		int retval = posix_memalign( &pRet, align < sizeof( void* ) ? sizeof( void* ) : align, size );
+		(void)retval;	//unused
+		return (char*)pRet;
+#endif
+	}
+	static void FreeChunk( char* p )
+	{
+#ifdef _WIN32
+		_aligned_free( p );
+#else
+		free( p );
+#endif
+	}
+#endif
+
 #if RCCPP_ALLOCATOR_INTERFACE
 	IObjectAllocator* 				m_pAllocator;
 #endif
@@ -299,6 +389,11 @@ private:
 	ConstructorId                   m_Id;
 	PerModuleInterface*             m_pModuleInterface;
     unsigned short                  m_Project;
+#if !RCCPP_ALLOCATOR_INTERFACE
+	std::vector<char*>				m_SlabChunks;
+	size_t							m_NumSlabObjects;
+	PerTypeObjectId					m_ConstructingId;
+#endif
 #ifndef RCCPPOFF
 	std::string                     m_FileName;
 	IRuntimeTracking*				m_pRuntimeTrackingList;
@@ -320,30 +415,15 @@ public:
 		m_Constructor.GetAllocator()->Free( p );
 	}
 #else
-#ifdef _WIN32
-	void* operator new(size_t size)
-	{
-		size_t align = __alignof( TActual<T> );
-		return _aligned_malloc( size, align );
-	}
-	void operator delete(void* p)
-	{
-		_aligned_free( p );
-	}
-#else
-	void* operator new(size_t size)
+	// placed in the slab of the constructor, see TObjectConstructorConcrete::AllocateSlot
+	void* operator new( size_t size )
 	{
-		size_t align = __alignof__( TActual<T> );
-		void* pRet;
-		int retval = posix_memalign( &pRet, align, size );
-		(void)retval;	//unused
-		return pRet;
+		return m_Constructor.AllocateSlot( size );
 	}
-	void operator delete(void* p)
+	void operator delete( void* p )
 	{
-		free( p );
+		m_Constructor.FreeSlot( p );
 	}
-#endif // _WIN32
 #endif // RCCPP_ALLOCATOR_INTERFACE
 	friend class TObjectConstructorConcrete<TActual>;
 	virtual ~TActual() { m_Constructor.DeRegister( m_Id ); }
@@ -62,10 +62,15 @@ RuntimeObjectSystem::RuntimeObjectSystem()
 	, m_pBuildTool(new BuildTool())
 	, m_bCompiling( false )
 	, m_bLastLoadModuleSuccess( false )
+	, m_bUnloadUnusedModules( true )
 	, m_bAutoCompile( true )
     , m_CurrentlyBuildingProject( 0 )
     , m_TotalLoadedModulesEver(1) // starts at one for current exe
     , m_bProtectionEnabled( true )
+    , m_bHaveFileChangeTime( false )
+    , m_bHaveCompileCompleteTime( false )
+    , m_TestBuildBatchSize( 1 )
+    , m_TestBuildBatch( 0 )
     , m_pImpl( 0 )
 {
     ProjectSettings::ms_DefaultIntermediatePath = FileSystemUtils::GetCurrentPath() / "Runtime";
@@ -133,6 +138,12 @@ void RuntimeObjectSystem::OnFileChange(const IAUDynArray<const char*>& filelist)
 		return;
 	}
 
+    if( !m_bCompiling )
+    {
+        m_FileChangeTime = GetTimeNow();
+        m_bHaveFileChangeTime = true;
+    }
+
     for( unsigned short proj = 0; proj < m_Projects.size(); ++proj )
     {
 
@@ -147,8 +158,8 @@ void RuntimeObjectSystem::OnFileChange(const IAUDynArray<const char*>& filelist)
         for( size_t i = 0; i < filelist.Size(); ++i )
         {
             // check this file is in our project list
-            TFileList::iterator it = std::find( m_Projects[ proj ].m_RuntimeFileList.begin( ), m_Projects[ proj ].m_RuntimeFileList.end( ), filelist[i] );
-            if( it == m_Projects[ proj ].m_RuntimeFileList.end() )
+            std::string fileKey = GetFileKey( filelist[i] );
+            if( m_Projects[ proj ].m_RuntimeFileKeys.find( fileKey ) == m_Projects[ proj ].m_RuntimeFileKeys.end() )
             {
                 continue;
             }
@@ -164,25 +175,27 @@ void RuntimeObjectSystem::OnFileChange(const IAUDynArray<const char*>& filelist)
                 pBuildFileList->push_back( fileToBuild );
 
                 // file may be a source dependency, check
-                TFileToFilesIterator itrCurr = m_Projects[ proj ].m_RuntimeSourceDependencyMap.begin( );
-                while( itrCurr != m_Projects[ proj ].m_RuntimeSourceDependencyMap.end( ) )
+                const FileDependencyIndex::TFileSet* pDependents = m_Projects[ proj ].m_RuntimeSourceDependencyIndex.GetDependents( fileToBuild.filePath );
+                if( pDependents )
                 {
-                    if( itrCurr->second == fileToBuild.filePath )
+                    for( FileDependencyIndex::TFileSet::const_iterator it2 = pDependents->begin(); it2 != pDependents->end(); ++it2 )
                     {
-                        BuildTool::FileToBuild fileToBuild2( itrCurr->first );
+                        BuildTool::FileToBuild fileToBuild2( it2->second );
                         pBuildFileList->push_back( fileToBuild2 );
                     }
-                    ++itrCurr;
                 }
            }
 
             if( bFindIncludeDependencies )
             {
-                TFileToFilesEqualRange range = m_Projects[ proj ].m_RuntimeIncludeMap.equal_range( fileToBuild.filePath );
-                for( TFileToFilesIterator it2 = range.first; it2 != range.second; ++it2 )
+                const FileDependencyIndex::TFileSet* pIncluders = m_Projects[ proj ].m_RuntimeIncludeIndex.GetDependents( fileToBuild.filePath );
+                if( pIncluders )
                 {
-                    BuildTool::FileToBuild fileToBuildFromIncludes( ( *it2 ).second, bForceIncludeDependencies );
-                    pBuildFileList->push_back( fileToBuildFromIncludes );
+                    for( FileDependencyIndex::TFileSet::const_iterator it2 = pIncluders->begin(); it2 != pIncluders->end(); ++it2 )
+                    {
+                        BuildTool::FileToBuild fileToBuildFromIncludes( it2->second, bForceIncludeDependencies );
+                        pBuildFileList->push_back( fileToBuildFromIncludes );
+                    }
                 }
             }
         }
@@ -196,7 +209,13 @@ void RuntimeObjectSystem::OnFileChange(const IAUDynArray<const char*>& filelist)
 
 bool RuntimeObjectSystem::GetIsCompiledComplete()
 {
-	return m_bCompiling && m_pBuildTool->GetIsComplete();
+	bool bComplete = m_bCompiling && m_pBuildTool->GetIsComplete();
+	if( bComplete && !m_bHaveCompileCompleteTime )
+	{
+		m_CompileCompleteTime = GetTimeNow();
+		m_bHaveCompileCompleteTime = true;
+	}
+	return bComplete;
 }
 
 void RuntimeObjectSystem::CompileAllInProject( bool bForceRecompile, unsigned short projectId_ )
@@ -257,8 +276,7 @@ void RuntimeObjectSystem::AddToRuntimeFileList( const char* filename, unsigned s
 void RuntimeObjectSystem::AddToRuntimeFileListImp( const FileSystemUtils::Path& filename, unsigned short projectId_ )
 {
     ProjectSettings& project = GetProject( projectId_ );
-    TFileList::iterator it = std::find( project.m_RuntimeFileList.begin( ), project.m_RuntimeFileList.end( ), filename );
-    if( it == project.m_RuntimeFileList.end( ) )
+    if( project.m_RuntimeFileKeys.insert( GetFileKey( filename ) ).second )
 	{
         project.m_RuntimeFileList.push_back( filename );
         m_pFileChangeNotifier->Watch( filename.c_str(), this );
@@ -276,15 +294,79 @@ void RuntimeObjectSystem::RemoveFromRuntimeFileList( const char* filename, unsig
 void RuntimeObjectSystem::RemoveFromRuntimeFileListImp( const FileSystemUtils::Path& filename, unsigned short projectId_ )
 {
     ProjectSettings& project = GetProject( projectId_ );
-    TFileList::iterator it = std::find( project.m_RuntimeFileList.begin( ), project.m_RuntimeFileList.end( ), filename );
-    if( it != project.m_RuntimeFileList.end( ) )
+    if( project.m_RuntimeFileKeys.erase( GetFileKey( filename ) ) )
 	{
-        project.m_RuntimeFileList.erase( it );
+        TFileList::iterator it = std::find( project.m_RuntimeFileList.begin( ), project.m_RuntimeFileList.end( ), filename );
+        if( it != project.m_RuntimeFileList.end( ) )
+        {
+            project.m_RuntimeFileList.erase( it );
+        }
 	}
 }
 
+std::string RuntimeObjectSystem::GetFileKey( const FileSystemUtils::Path& path_ )
+{
+    FileSystemUtils::Path key = path_.GetCleanPath();
+    key.ToOSCanonicalCase();
+    return key.m_string;
+}
+
+void RuntimeObjectSystem::FileDependencyIndex::Add( const FileSystemUtils::Path& file_, const FileSystemUtils::Path& dependent_ )
+{
+    std::string fileKey      = GetFileKey( file_ );
+    std::string dependentKey = GetFileKey( dependent_ );
+    m_FileToDependents[ fileKey ][ dependentKey ] = dependent_;
+    m_DependentToFiles[ dependentKey ][ fileKey ] = file_;
+}
+
+void RuntimeObjectSystem::FileDependencyIndex::RemoveDependent( const FileSystemUtils::Path& dependent_ )
+{
+    std::string dependentKey = GetFileKey( dependent_ );
+    TFileToFileSetMap::iterator itrFiles = m_DependentToFiles.find( dependentKey );
+    if( itrFiles == m_DependentToFiles.end() )
+    {
+        return;
+    }
+    for( TFileSet::iterator it = itrFiles->second.begin(); it != itrFiles->second.end(); ++it )
+    {
+        TFileToFileSetMap::iterator itrDependents = m_FileToDependents.find( it->first );
+        if( itrDependents != m_FileToDependents.end() )
+        {
+            itrDependents->second.erase( dependentKey );
+            if( itrDependents->second.empty() )
+            {
+                m_FileToDependents.erase( itrDependents );
+            }
+        }
+    }
+    m_DependentToFiles.erase( itrFiles );
+}
+
+const RuntimeObjectSystem::FileDependencyIndex::TFileSet* RuntimeObjectSystem::FileDependencyIndex::GetDependents( const FileSystemUtils::Path& file_ ) const
+{
+    TFileToFileSetMap::const_iterator it = m_FileToDependents.find( GetFileKey( file_ ) );
+    return it != m_FileToDependents.end() ? &it->second : NULL;
+}
+
+const RuntimeObjectSystem::FileDependencyIndex::TFileSet* RuntimeObjectSystem::FileDependencyIndex::GetFiles( const FileSystemUtils::Path& dependent_ ) const
+{
+    TFileToFileSetMap::const_iterator it = m_DependentToFiles.find( GetFileKey( dependent_ ) );
+    return it != m_DependentToFiles.end() ? &it->second : NULL;
+}
+
 void RuntimeObjectSystem::StartRecompile()
 {
+    TimePoint startTime = GetTimeNow();
+    m_CurrentReloadReport = ReloadReport();
+    m_ReloadStartTime = startTime;
+    if( m_bHaveFileChangeTime )
+    {
+        m_ReloadStartTime = m_FileChangeTime;
+        m_CurrentReloadReport.fileChangeToCompileSeconds = std::chrono::duration<double>( startTime - m_FileChangeTime ).count();
+        m_bHaveFileChangeTime = false;
+    }
+    m_bHaveCompileCompleteTime = false;
+
     m_bCompiling = true;
     if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo( "Compiling...\n" ); }
 
@@ -366,12 +448,15 @@ void RuntimeObjectSystem::StartRecompile()
 	for( size_t i = 0; i < buildListSize; ++ i )
 	{
 
-        TFileToFilesEqualRange range = m_Projects[ project ].m_RuntimeSourceDependencyMap.equal_range( ourBuildFileList[ i ].filePath );
-		for(TFileToFilesIterator it=range.first; it!=range.second; ++it)
-		{
-		    BuildTool::FileToBuild reqFile( it->second, false );	//don't force compile of these
-			ourBuildFileList.push_back( reqFile );
-		}
+        const FileDependencyIndex::TFileSet* pDependencies = m_Projects[ project ].m_RuntimeSourceDependencyIndex.GetFiles( ourBuildFileList[ i ].filePath );
+        if( pDependencies )
+        {
+            for( FileDependencyIndex::TFileSet::const_iterator it = pDependencies->begin(); it != pDependencies->end(); ++it )
+            {
+                BuildTool::FileToBuild reqFile( it->second, false );	//don't force compile of these
+                ourBuildFileList.push_back( reqFile );
+            }
+        }
 	}
 
 	m_Projects[ project ].m_CompilerOptions.intermediatePath = GetIntermediateFolder(	m_Projects[ project ].m_CompilerOptions.baseIntermediatePath,
@@ -381,6 +466,23 @@ void RuntimeObjectSystem::StartRecompile()
     m_pBuildTool->BuildModule(  ourBuildFileList,
                                 m_Projects[ project ].m_CompilerOptions,
 								linkLibraryList2, m_CurrentlyCompilingModuleName );
+
+    m_CurrentReloadReport.projectId = project;
+    m_CurrentReloadReport.startCompileSeconds = GetSecondsSince( startTime );
+}
+
+void RuntimeObjectSystem::CompleteReloadReport( bool bSucceeded_ )
+{
+    m_CurrentReloadReport.bSucceeded = bSucceeded_;
+    m_CurrentReloadReport.totalSeconds = GetSecondsSince( m_ReloadStartTime );
+    m_LastReloadReport = m_CurrentReloadReport;
+    if( m_pCompilerLogger )
+    {
+        m_pCompilerLogger->LogInfo( "Reload took %.3fs: compile %.3fs (link %.3fs), load module %.3fs, object swap %.3fs\n",
+                                    m_LastReloadReport.totalSeconds, m_LastReloadReport.compile.totalSeconds,
+                                    m_LastReloadReport.compile.linkSeconds, m_LastReloadReport.loadModuleSeconds,
+                                    m_LastReloadReport.objectSwap.total );
+    }
 }
 
 bool RuntimeObjectSystem::LoadCompiledModule()
@@ -388,6 +490,13 @@ bool RuntimeObjectSystem::LoadCompiledModule()
 	m_bLastLoadModuleSuccess = false;
 	m_bCompiling = false;
 
+	TimePoint loadStartTime = GetTimeNow();
+	m_CurrentReloadReport.compile = m_pBuildTool->GetCompileTimings();
+	if( m_bHaveCompileCompleteTime )
+	{
+		m_CurrentReloadReport.waitForLoadSeconds = std::chrono::duration<double>( loadStartTime - m_CompileCompleteTime ).count();
+	}
+
 	// Since the temporary file is created with 0 bytes, loadlibrary can fail with a dialogue we want to prevent. So check size
 	// We pass in the ec value so the function won't throw an exception on error, but the value itself sometimes seems to
 	// be set even without an error, so not sure if it should be relied on.
@@ -406,6 +515,7 @@ bool RuntimeObjectSystem::LoadCompiledModule()
 	if (!module)
 	{
 		if (m_pCompilerLogger) { m_pCompilerLogger->LogError( "Failed to load module %s\n",m_CurrentlyCompilingModuleName.c_str()); }
+		CompleteReloadReport( false );
 		return false;
 	}
 
@@ -419,19 +529,27 @@ bool RuntimeObjectSystem::LoadCompiledModule()
 	if (!pPerModuleInterfaceProcAdd)
 	{
 		if (m_pCompilerLogger) { m_pCompilerLogger->LogError( "Failed GetProcAddress\n"); }
+		CompleteReloadReport( false );
 		return false;
 	}
 
     pPerModuleInterfaceProcAdd()->SetModuleFileName( m_CurrentlyCompilingModuleName.c_str() );
     pPerModuleInterfaceProcAdd( )->SetProjectIdForAllConstructors( m_CurrentlyBuildingProject );
-    m_Modules.push_back( module );
+    LoadedModule loadedModule = { module, pPerModuleInterfaceProcAdd(), m_CurrentlyCompilingModuleName, 0 };
+    m_Modules.push_back( loadedModule );
+	m_CurrentReloadReport.loadModuleSeconds = GetSecondsSince( loadStartTime );
 
 	if (m_pCompilerLogger) { m_pCompilerLogger->LogInfo( "Compilation Succeeded\n"); }
     ++m_TotalLoadedModulesEver;
 
+	TimePoint setupStartTime = GetTimeNow();
 	SetupObjectConstructors(pPerModuleInterfaceProcAdd());
+	m_CurrentReloadReport.objectSwap = m_pObjectFactorySystem->GetLastObjectSwapTimings();
+	m_CurrentReloadReport.setupConstructorsSeconds = GetSecondsSince( setupStartTime ) - m_CurrentReloadReport.objectSwap.total;
     m_Projects[ m_CurrentlyBuildingProject ].m_BuildFileList.clear( );	// clear the files from our compile list
 	m_bLastLoadModuleSuccess = true;
+	UnloadUnusedModules();
+	CompleteReloadReport( true );
 
     // check if there is another project to build
     bool bNeedAnotherCompile = false;
@@ -510,26 +628,13 @@ void RuntimeObjectSystem::SetupRuntimeFileTracking(const IAUDynArray<IObjectCons
 		if( !bFirstTime )
 		{
  			//remove old include file mappings for this file
-            TFileToFilesIterator itrCurr = project.m_RuntimeIncludeMap.begin( );
-            while( itrCurr != project.m_RuntimeIncludeMap.end( ) )
-			{
-				if( itrCurr->second == filePath )
-				{
-                    TFileToFilesIterator itrErase = itrCurr;
-                    ++itrCurr;
-                    project.m_RuntimeIncludeMap.erase( itrErase );
-				}
-				else
-				{
-					++itrCurr;
-				}
-			}
+            project.m_RuntimeIncludeIndex.RemoveDependent( filePath );
 
             //remove previous link libraries for this file
             project.m_RuntimeLinkLibraryMap.erase( filePath );
 
             //remove previous source dependencies
-            project.m_RuntimeSourceDependencyMap.erase( filePath );
+            project.m_RuntimeSourceDependencyIndex.RemoveDependent( filePath );
 		}
 
         //we need the compile path for some platforms where the __FILE__ path is relative to the compile path
@@ -546,11 +651,8 @@ void RuntimeObjectSystem::SetupRuntimeFileTracking(const IAUDynArray<IObjectCons
 			{
                 FileSystemUtils::Path pathInc = compileDir / pIncludeFile;
                 pathInc = FindFile( pathInc.GetCleanPath() );
-				TFileToFilePair includePathPair;
-				includePathPair.first = pathInc;
-				includePathPair.second = filePath;
                 AddToRuntimeFileListImp( pathInc, projectId );
-                project.m_RuntimeIncludeMap.insert( includePathPair );
+                project.m_RuntimeIncludeIndex.Add( pathInc, filePath );
 			}
 
 			//add link library file mappings
@@ -597,25 +699,18 @@ void RuntimeObjectSystem::SetupRuntimeFileTracking(const IAUDynArray<IObjectCons
 					pathSrc.ReplaceExtension( sourceDependency.extension );
 				}
 				pathSrc = FindFile( pathSrc.GetCleanPath() );
-				TFileToFilePair sourcePathPair;
-				sourcePathPair.first = filePath;
-				sourcePathPair.second = pathSrc;
-                project.m_RuntimeSourceDependencyMap.insert( sourcePathPair );
+                project.m_RuntimeSourceDependencyIndex.Add( pathSrc, filePath );
                 
                 // if the include file with a source dependancy is logged as an runtime include, then we mark this .cpp as compile dependencies on change
 				for( int inc=0; inc<2; ++inc )
 				{
-					TFileToFilesEqualRange range = project.m_RuntimeIncludeMap.equal_range( pathInc[inc] );
-					if( range.first != range.second )
+					if( project.m_RuntimeIncludeIndex.GetDependents( pathInc[inc] ) )
 					{
 						// add source file to runtime file list
 						AddToRuntimeFileListImp( pathSrc, projectId );
 
 						// also add this as a source dependency, so it gets force compiled on change of header (and not just compiled)
-						TFileToFilePair includePathPair;
-						includePathPair.first = pathInc[inc];
-						includePathPair.second = pathSrc;
-						project.m_RuntimeIncludeMap.insert( includePathPair );
+						project.m_RuntimeIncludeIndex.Add( pathInc[inc], pathSrc );
 					}
 				}
 			}
@@ -672,11 +767,109 @@ RCppOptimizationLevel RuntimeObjectSystem::GetOptimizationLevel(					unsigned sh
 	return GetProject( projectId_ ).m_CompilerOptions.optimizationLevel;
 }
 
+void RuntimeObjectSystem::SetMaxParallelCompiles( unsigned int maxParallelCompiles_,	unsigned short projectId_ )
+{
+    GetProject( projectId_ ).m_CompilerOptions.maxParallelCompiles = maxParallelCompiles_;
+}
+
+void RuntimeObjectSystem::SetPrecompiledHeader(          const char* path_,      unsigned short projectId_ )
+{
+	GetProject( projectId_ ).m_CompilerOptions.precompiledHeader = path_ ? path_ : "";
+}
+
 void RuntimeObjectSystem::SetIntermediateDir(            const char* path_,      unsigned short projectId_ )
 {
 	GetProject( projectId_ ).m_CompilerOptions.baseIntermediatePath = path_;
 }
 
+void RuntimeObjectSystem::SetObjectCache( const char* path_, unsigned long long maxSizeBytes_ )
+{
+    if( m_pBuildTool )
+    {
+        FileSystemUtils::Path cachePath = ProjectSettings::ms_DefaultIntermediatePath / "ObjectCache";
+        if( path_ )
+        {
+            cachePath = path_;
+        }
+        m_pBuildTool->SetObjectCache( cachePath, maxSizeBytes_ );
+    }
+}
+
+RuntimeObjectSystem::LoadedModule* RuntimeObjectSystem::FindModule( IObjectConstructor* pConstructor_ )
+{
+    for( size_t i = 0; i < m_Modules.size(); ++i )
+    {
+        const std::vector<IObjectConstructor*>& constructors = m_Modules[i].pPerModuleInterface->GetConstructors();
+        if( std::find( constructors.begin(), constructors.end(), pConstructor_ ) != constructors.end() )
+        {
+            return &m_Modules[i];
+        }
+    }
+    return 0; // constructor is in the exe
+}
+
+void RuntimeObjectSystem::AddModuleReference( IObjectConstructor* pConstructor_ )
+{
+    LoadedModule* pModule = FindModule( pConstructor_ );
+    if( pModule )
+    {
+        ++pModule->references;
+    }
+}
+
+void RuntimeObjectSystem::RemoveModuleReference( IObjectConstructor* pConstructor_ )
+{
+    LoadedModule* pModule = FindModule( pConstructor_ );
+    if( pModule && pModule->references > 0 )
+    {
+        --pModule->references;
+    }
+}
+
+unsigned int RuntimeObjectSystem::UnloadUnusedModules()
+{
+    if( !m_bUnloadUnusedModules )
+    {
+        return 0;
+    }
+
+    unsigned int numUnloaded = 0;
+    size_t moduleIndex = 0;
+    while( moduleIndex < m_Modules.size() )
+    {
+        LoadedModule& loadedModule = m_Modules[ moduleIndex ];
+        bool bInUse = loadedModule.references > 0;
+        const std::vector<IObjectConstructor*>& constructors = loadedModule.pPerModuleInterface->GetConstructors();
+        for( size_t i = 0; i < constructors.size() && !bInUse; ++i )
+        {
+            bInUse = m_pObjectFactorySystem->GetIsConstructorInUse( constructors[i] );
+        }
+        if( bInUse )
+        {
+            ++moduleIndex;
+            continue;
+        }
+
+#ifdef _WIN32
+        bool bClosed = 0 != FreeLibrary( loadedModule.module );
+#else
+        bool bClosed = 0 == dlclose( loadedModule.module );
+#endif
+        if( bClosed )
+        {
+            loadedModule.path.Remove();
+            if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo( "Unloaded unused module %s\n", loadedModule.path.c_str() ); }
+        }
+        else
+        {
+            if( m_pCompilerLogger ) { m_pCompilerLogger->LogWarning( "Failed to unload unused module %s\n", loadedModule.path.c_str() ); }
+        }
+        m_Modules.erase( m_Modules.begin() + moduleIndex );
+        ++numUnloaded;
+    }
+    return numUnloaded;
+}
+
 void RuntimeObjectSystem::CleanObjectFiles() const
 {
     if( m_pBuildTool )
@@ -901,104 +1094,202 @@ bool RuntimeObjectSystem::TestBuildCallback(const char* file, TestBuildResult ty
     return true;
 }
 
+static const char* TestBuildResultName( TestBuildResult type_ )
+{
+    switch( type_ )
+    {
+    case TESTBUILDRRESULT_SUCCESS:              return "SUCCESS";
+    case TESTBUILDRRESULT_NO_FILES_TO_BUILD:    return "NO_FILES_TO_BUILD";
+    case TESTBUILDRRESULT_BUILD_FILE_GONE:      return "BUILD_FILE_GONE";
+    case TESTBUILDRRESULT_BUILD_NOT_STARTED:    return "BUILD_NOT_STARTED";
+    case TESTBUILDRRESULT_BUILD_FAILED:         return "BUILD_FAILED";
+    case TESTBUILDRRESULT_OBJECT_SWAP_FAIL:     return "OBJECT_SWAP_FAIL";
+    }
+    return "UNKNOWN";
+}
+
+// Notifies the callback of the result of each file in a test batch and adds them to the report.
+// Returns false if the callback ends the test.
+bool RuntimeObjectSystem::TestBuildNotifyResults( ITestBuildNotifier* callback, const TFileList& files_,
+                                                  TestBuildResult type_, const TestBuildReloadTimes& times_ )
+{
+    bool bContinue = true;
+    for( size_t i = 0; i < files_.size(); ++i )
+    {
+        TestBuildReportEntry entry;
+        entry.file = files_[i];
+        entry.batch = m_TestBuildBatch;
+        entry.result = type_;
+        entry.times = times_;
+        entry.fileCompileSeconds = -1.0;
+        std::string fileKey = GetFileKey( files_[i] );
+        for( size_t t = 0; t < times_.compileFiles.size(); ++t )
+        {
+            // preprocess timings have a suffix on the file name
+            const std::string& timingFile = times_.compileFiles[t].file;
+            size_t suffix = timingFile.find( " (" );
+            if( GetFileKey( timingFile.substr( 0, suffix ) ) == fileKey )
+            {
+                entry.fileCompileSeconds = std::max( entry.fileCompileSeconds, 0.0 ) + times_.compileFiles[t].seconds;
+            }
+        }
+        m_TestBuildReport.push_back( entry );
+        if( bContinue && !callback->TestBuildCallback( files_[i].c_str(), type_ ) )
+        {
+            bContinue = false;
+        }
+    }
+    return bContinue;
+}
+
+// Changes all files in files_, which must be in one project, and waits for them to be compiled and
+// loaded. Files which fail in a batch of more than one file are retested one by one.
 // returns 0 on success, -ve number of errors if there is an error and we should quit,
 // positive number of errors if there is an error but we should continue
-static int TestBuildFile( ICompilerLogger* pLog, RuntimeObjectSystem* pRTObjSys, const Path& file,
-                          ITestBuildNotifier* callback, bool bTestFileTracking )
+int RuntimeObjectSystem::TestBuildBatch( const TFileList& files_, unsigned short projectId_,
+                                         ITestBuildNotifier* callback, bool bTestFileTracking )
 {
     assert( callback );
 
-    if( pLog ) { pLog->LogInfo("Testing change to file: %s\n", file.c_str()); }
-
     int numErrors = 0;
-    if( file.Exists() )
+    TFileList filesToBuild;
+    for( size_t i = 0; i < files_.size(); ++i )
+    {
+        if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("Testing change to file: %s\n", files_[i].c_str()); }
+        if( files_[i].Exists() )
+        {
+            filesToBuild.push_back( files_[i] );
+        }
+        else
+        {
+            ++numErrors;
+            TFileList fileGone( 1, files_[i] );
+            if( !TestBuildNotifyResults( callback, fileGone, TESTBUILDRRESULT_BUILD_FILE_GONE, TestBuildReloadTimes() ) ) { return -numErrors; }
+        }
+    }
+    if( filesToBuild.empty() )
+    {
+        return numErrors;
+    }
+
+    if( bTestFileTracking )
     {
-        if( bTestFileTracking )
+        FileSystemUtils::filetime_t currTime = FileSystemUtils::GetCurrentTime();
+        for( size_t i = 0; i < filesToBuild.size(); ++i )
         {
-            FileSystemUtils::filetime_t currTime = FileSystemUtils::GetCurrentTime();
+            const Path& file = filesToBuild[i];
+            FileSystemUtils::filetime_t fileTime = currTime;
             FileSystemUtils::filetime_t oldModTime = file.GetLastWriteTime();
-            if( currTime == oldModTime )
+            if( fileTime == oldModTime )
             {
                 // some files may be auto-generated by the program, so may have just been created so won't
                 // get a time change unless we force it.
-                currTime += 1;
+                fileTime += 1;
             }
-            file.SetLastWriteTime( currTime );
+            file.SetLastWriteTime( fileTime );
             // we must also change the directories time, as some of our watchers watch the dir
             Path directory = file.ParentPath();
-            directory.SetLastWriteTime( currTime );
-            for( int i=0; i<50; ++i )
+            directory.SetLastWriteTime( fileTime );
+        }
+        for( int i=0; i<50; ++i )
+        {
+            // wait up to 100 seconds (make configurable?)
+            GetFileChangeNotifier()->Update( 1.0f ); // force update by using very large time delta
+            if( GetIsCompiling() ) { break; }
+            if( !callback->TestBuildWaitAndUpdate() )
             {
-                // wait up to 100 seconds (make configurable?)
-                pRTObjSys->GetFileChangeNotifier()->Update( 1.0f ); // force update by using very large time delta
-                if( pRTObjSys->GetIsCompiling() ) { break; }
-                if( !callback->TestBuildWaitAndUpdate() )
-                {
-                    return -0xD1E;
-                }
+                return -0xD1E;
             }
         }
-        else
+    }
+    else
+    {
+        AUDynArray<const char*> filelist( filesToBuild.size() );
+        for( size_t i = 0; i < filesToBuild.size(); ++i )
         {
-            AUDynArray<const char*> filelist;
-            filelist.Add( file.c_str() );
-            pRTObjSys->OnFileChange( filelist );
+            filelist[i] = filesToBuild[i].c_str();
         }
-        if( pRTObjSys->GetIsCompiling() )
+        OnFileChange( filelist );
+    }
+
+    if( !GetIsCompiling() )
+    {
+        numErrors += (int)filesToBuild.size();
+        if( !TestBuildNotifyResults( callback, filesToBuild, TESTBUILDRRESULT_BUILD_NOT_STARTED, TestBuildReloadTimes() ) ) { return -numErrors; }
+        return numErrors;
+    }
+
+    // file change notifications arriving during a compile start another, so wait until all have loaded
+    TestBuildResult result = TESTBUILDRRESULT_SUCCESS;
+    TestBuildReloadTimes times;
+    while( GetIsCompiling() )
+    {
+        while( !GetIsCompiledComplete() )
         {
-            while( !pRTObjSys->GetIsCompiledComplete() )
-            {
-                if( !callback->TestBuildWaitAndUpdate() )
-                {
-                    return -0xD1E;
-                }
-            }
-            int numCurrLoadedModules = pRTObjSys->GetNumberLoadedModules();
-            if( pRTObjSys->LoadCompiledModule() )
+            if( !callback->TestBuildWaitAndUpdate() )
             {
-                if( !callback->TestBuildCallback( file.c_str(), TESTBUILDRRESULT_SUCCESS ) ) { return -0xD1E; }
-                return 0;
-            }
-            else
-            {
-                ++numErrors;
-                if( (int)pRTObjSys->GetNumberLoadedModules() == numCurrLoadedModules )
-                {
-                    if( !callback->TestBuildCallback( file.c_str(), TESTBUILDRRESULT_BUILD_FAILED ) ) { return -numErrors; }
-                }
-                else
-                {
-                    // loaded the module but some other issue
-                    if( !callback->TestBuildCallback( file.c_str(), TESTBUILDRRESULT_OBJECT_SWAP_FAIL ) ) { return -numErrors; }
-                }
+                return -0xD1E;
             }
         }
-        else
+        unsigned int numCurrLoadedModules = GetNumberLoadedModules();
+        bool bLoaded = LoadCompiledModule();
+        const ReloadReport& reload = GetLastReloadReport();
+        times.compileSeconds += reload.compile.totalSeconds;
+        times.linkSeconds += reload.compile.linkSeconds;
+        times.loadModuleSeconds += reload.loadModuleSeconds;
+        times.objectSwapSeconds += reload.objectSwap.total;
+        times.reloadSeconds += reload.totalSeconds;
+        times.compileFiles.insert( times.compileFiles.end(), reload.compile.files.begin(), reload.compile.files.end() );
+        if( !bLoaded && TESTBUILDRRESULT_SUCCESS == result )
         {
-            ++numErrors;
-           if( !callback->TestBuildCallback( file.c_str(), TESTBUILDRRESULT_BUILD_NOT_STARTED ) ) { return -numErrors; }
+            // loaded the module but some other issue if the number of modules changed
+            result = GetNumberLoadedModules() == numCurrLoadedModules ? TESTBUILDRRESULT_BUILD_FAILED : TESTBUILDRRESULT_OBJECT_SWAP_FAIL;
         }
     }
-    else
+
+    if( TESTBUILDRRESULT_SUCCESS != result && filesToBuild.size() > 1 )
     {
-        ++numErrors;
-        if( !callback->TestBuildCallback( file.c_str(), TESTBUILDRRESULT_BUILD_FILE_GONE ) ) { return -numErrors; }
+        if( m_pCompilerLogger ) { m_pCompilerLogger->LogWarning("Test batch %u failed, testing its files one by one\n", m_TestBuildBatch); }
+        for( size_t i = 0; i < filesToBuild.size(); ++i )
+        {
+            // failed files stay in the build list to be retried with the next change, remove them so
+            // each file is tested on its own
+            m_Projects[ projectId_ ].m_BuildFileList.clear();
+            ++m_TestBuildBatch;
+            int fileErrors = TestBuildBatch( TFileList( 1, filesToBuild[i] ), projectId_, callback, bTestFileTracking );
+            if( fileErrors < 0 )
+            {
+                return fileErrors == -0xD1E ? -0xD1E : fileErrors - numErrors;
+            }
+            numErrors += fileErrors;
+        }
+        return numErrors;
+    }
+
+    if( TESTBUILDRRESULT_SUCCESS != result )
+    {
+        numErrors += (int)filesToBuild.size();
+    }
+    if( !TestBuildNotifyResults( callback, filesToBuild, result, times ) )
+    {
+        return numErrors ? -numErrors : -0xD1E;
     }
     return numErrors;
 }
 
-// tests one by one touching each runtime modifiable source file
+// tests touching each runtime modifiable source file or each header, in batches of m_TestBuildBatchSize files.
 // returns the number of errors - 0 if all passed.
-int RuntimeObjectSystem::TestBuildAllRuntimeSourceFiles(  ITestBuildNotifier* callback, bool bTestFileTracking )
+int RuntimeObjectSystem::TestBuildAllRuntimeFiles( ITestBuildNotifier* callback, bool bTestFileTracking, bool bHeaders )
 {
-    if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("TestBuildAllRuntimeSourceFiles Starting\n"); }
-   
     ITestBuildNotifier* failCallbackLocal = callback;
     if( !failCallbackLocal )
     {
         failCallbackLocal = this;
     }
 
+    TimePoint startTime = GetTimeNow();
+    m_TestBuildReport.clear();
+    m_TestBuildBatch = 0;
     int numErrors = 0;
 
     size_t numFilesToBuild = 0;
@@ -1011,16 +1302,25 @@ int RuntimeObjectSystem::TestBuildAllRuntimeSourceFiles(  ITestBuildNotifier* ca
     {
         failCallbackLocal->TestBuildCallback( NULL, TESTBUILDRRESULT_NO_FILES_TO_BUILD );
     }
-    
-    for( unsigned short proj = 0; proj < m_Projects.size(); ++proj )
+
+    size_t batchSize = std::max( m_TestBuildBatchSize, 1u );
+    bool bContinue = true;
+    for( unsigned short proj = 0; bContinue && proj < m_Projects.size(); ++proj )
     {
         TFileList filesToTest = m_Projects[ proj ].m_RuntimeFileList; // m_RuntimeFileList could change if file content changes (new includes or source dependencies) so make copy to ensure iterators valid.
-        for( TFileList::iterator it = filesToTest.begin(); it != filesToTest.end(); ++it )
+        TFileList batch;
+        for( size_t i = 0; bContinue && i < filesToTest.size(); ++i )
         {
-            const Path& file = *it;
-            if( file.Extension() != ".h" ) // exclude headers, use TestBuildAllRuntimeHeaders
+            const Path& file = filesToTest[i];
+            if( ( file.Extension() == ".h" ) == bHeaders ) // headers are tested with TestBuildAllRuntimeHeaders
+            {
+                batch.push_back( file );
+            }
+            if( batch.size() && ( batch.size() == batchSize || i + 1 == filesToTest.size() ) )
             {
-                int fileErrors = TestBuildFile( m_pCompilerLogger, this, file, failCallbackLocal, bTestFileTracking );
+                int fileErrors = TestBuildBatch( batch, proj, failCallbackLocal, bTestFileTracking );
+                batch.clear();
+                ++m_TestBuildBatch;
                 if( fileErrors < 0 )
                 {
                     // this means exit, and the number of errors is -ve so remove, unless -0xD1E is the response (for no error die)
@@ -1028,13 +1328,22 @@ int RuntimeObjectSystem::TestBuildAllRuntimeSourceFiles(  ITestBuildNotifier* ca
                     {
                         numErrors -= fileErrors;
                     }
-                    return numErrors;
+                    bContinue = false;
+                }
+                else
+                {
+                    numErrors += fileErrors;
                 }
-                numErrors += fileErrors;
             }
         }
     }
 
+    WriteTestBuildReport( GetSecondsSince( startTime ) );
+    if( !bContinue )
+    {
+        return numErrors;
+    }
+
     if( 0 == numErrors )
     {
         if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("All Tests Passed\n"); }
@@ -1046,56 +1355,105 @@ int RuntimeObjectSystem::TestBuildAllRuntimeSourceFiles(  ITestBuildNotifier* ca
     return numErrors;
 }
 
-// tests touching each header which has RUNTIME_MODIFIABLE_INCLUDE.
-// returns the number of errors - 0 if all passed.
+int RuntimeObjectSystem::TestBuildAllRuntimeSourceFiles(  ITestBuildNotifier* callback, bool bTestFileTracking )
+{
+    if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("TestBuildAllRuntimeSourceFiles Starting\n"); }
+    return TestBuildAllRuntimeFiles( callback, bTestFileTracking, false );
+}
+
 int RuntimeObjectSystem::TestBuildAllRuntimeHeaders(      ITestBuildNotifier* callback, bool bTestFileTracking )
 {
-    ITestBuildNotifier* failCallbackLocal = callback;
-    if( !failCallbackLocal )
+    return TestBuildAllRuntimeFiles( callback, bTestFileTracking, true );
+}
+
+static void WriteJSONString( FILE* pFile_, const char* str_ )
+{
+    fputc( '"', pFile_ );
+    for( const char* pC = str_; *pC; ++pC )
     {
-        failCallbackLocal = this;
+        if( '"' == *pC || '\\' == *pC )
+        {
+            fputc( '\\', pFile_ );
+            fputc( *pC, pFile_ );
+        }
+        else if( (unsigned char)*pC < 0x20 )
+        {
+            fprintf( pFile_, "\\u%04x", (unsigned int)(unsigned char)*pC );
+        }
+        else
+        {
+            fputc( *pC, pFile_ );
+        }
     }
+    fputc( '"', pFile_ );
+}
 
-    int numErrors = 0;
-
-    size_t numFilesToBuild = 0;
-    for( unsigned short proj = 0; proj < m_Projects.size( ); ++proj )
+void RuntimeObjectSystem::WriteTestBuildReport( double totalSeconds_ ) const
+{
+    if( m_TestBuildReportPath.m_string.empty() )
     {
-        numFilesToBuild += m_Projects[ proj ].m_RuntimeFileList.size( );
+        return;
     }
 
-    if( 0 == numFilesToBuild )
+    FILE* pFile = fopen( m_TestBuildReportPath.c_str(), "w" );
+    if( !pFile )
     {
-        failCallbackLocal->TestBuildCallback( NULL, TESTBUILDRRESULT_NO_FILES_TO_BUILD );
+        if( m_pCompilerLogger ) { m_pCompilerLogger->LogError("Failed to write test build report %s\n", m_TestBuildReportPath.c_str()); }
+        return;
     }
 
-    for( unsigned short proj = 0; proj < m_Projects.size(); ++proj )
+    // files in a batch share the timings of its reloads, fileCompileSeconds is only present for source files compiled
+    bool bJSON = m_TestBuildReportPath.Extension() == ".json";
+    if( bJSON )
     {
-        TFileList filesToTest = m_Projects[ proj ].m_RuntimeFileList; // m_RuntimeFileList could change if file content changes (new includes or source dependencies) so make copy to ensure iterators valid.
-        for( TFileList::iterator it = filesToTest.begin( ); it != filesToTest.end( ); ++it )
+        fprintf( pFile, "{\n  \"batchSize\": %u,\n  \"totalSeconds\": %.6f,\n  \"files\": [", std::max( m_TestBuildBatchSize, 1u ), totalSeconds_ );
+    }
+    else
+    {
+        fprintf( pFile, "file,batch,result,fileCompileSeconds,compileSeconds,linkSeconds,loadModuleSeconds,objectSwapSeconds,reloadSeconds\n" );
+    }
+    for( size_t i = 0; i < m_TestBuildReport.size(); ++i )
+    {
+        const TestBuildReportEntry& entry = m_TestBuildReport[i];
+        if( bJSON )
         {
-            const Path& file = *it;
-            if( file.Extension() == ".h" ) // exclude headers, use TestBuildAllRuntimeHeaders
+            fprintf( pFile, "%s\n    { \"file\": ", i ? "," : "" );
+            WriteJSONString( pFile, entry.file.c_str() );
+            fprintf( pFile, ", \"batch\": %u, \"result\": \"%s\", \"fileCompileSeconds\": ", entry.batch, TestBuildResultName( entry.result ) );
+            if( entry.fileCompileSeconds >= 0.0 )
             {
-                int fileErrors = TestBuildFile( m_pCompilerLogger, this, file, failCallbackLocal, bTestFileTracking );
-                if( fileErrors < 0 )
-                {
-                    // this means exit, and the number of errors is -ve so remove
-                    return numErrors - fileErrors;
-                }
-                numErrors += fileErrors;
+                fprintf( pFile, "%.6f", entry.fileCompileSeconds );
             }
+            else
+            {
+                fprintf( pFile, "null" );
+            }
+            fprintf( pFile, ", \"compileSeconds\": %.6f, \"linkSeconds\": %.6f, \"loadModuleSeconds\": %.6f, \"objectSwapSeconds\": %.6f, \"reloadSeconds\": %.6f }",
+                     entry.times.compileSeconds, entry.times.linkSeconds, entry.times.loadModuleSeconds,
+                     entry.times.objectSwapSeconds, entry.times.reloadSeconds );
+        }
+        else
+        {
+            fputc( '"', pFile );
+            for( const char* pC = entry.file.c_str(); *pC; ++pC )
+            {
+                if( '"' == *pC ) { fputc( '"', pFile ); }
+                fputc( *pC, pFile );
+            }
+            fprintf( pFile, "\",%u,%s,", entry.batch, TestBuildResultName( entry.result ) );
+            if( entry.fileCompileSeconds >= 0.0 )
+            {
+                fprintf( pFile, "%.6f", entry.fileCompileSeconds );
+            }
+            fprintf( pFile, ",%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                     entry.times.compileSeconds, entry.times.linkSeconds, entry.times.loadModuleSeconds,
+                     entry.times.objectSwapSeconds, entry.times.reloadSeconds );
         }
     }
-
-
-    if( 0 == numErrors )
-    {
-        if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("All Tests Passed\n"); }
-    }
-    else
+    if( bJSON )
     {
-        if( m_pCompilerLogger ) { m_pCompilerLogger->LogError("Tests Failed: %d\n", numErrors); }
+        fprintf( pFile, "\n  ]\n}\n" );
     }
-    return numErrors;
+    fclose( pFile );
+    if( m_pCompilerLogger ) { m_pCompilerLogger->LogInfo("Test build report written to %s\n", m_TestBuildReportPath.c_str()); }
 }
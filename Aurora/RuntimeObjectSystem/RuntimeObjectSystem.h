@@ -35,6 +35,9 @@
 #endif
 #include <vector>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "../RuntimeCompiler/FileSystemUtils.h"
 
@@ -90,6 +93,8 @@ public:
     virtual void SetCompilerLocation        (   const char* path,       unsigned short projectId_ = 0 );
     virtual void SetOptimizationLevel( RCppOptimizationLevel optimizationLevel_,	unsigned short projectId_ = 0 );
     virtual RCppOptimizationLevel GetOptimizationLevel(					unsigned short projectId_ = 0 );
+    virtual void SetMaxParallelCompiles( unsigned int maxParallelCompiles_,	unsigned short projectId_ = 0 );
+    virtual void SetPrecompiledHeader(          const char* path_,      unsigned short projectId_ = 0 );
     virtual void SetIntermediateDir(            const char* path_,      unsigned short projectId_ = 0 );
 
 	virtual void SetAutoCompile( bool autoCompile );
@@ -106,6 +111,8 @@ public:
         }
     }
 
+    virtual void SetObjectCache( const char* path_, unsigned long long maxSizeBytes_ );
+
     virtual void CleanObjectFiles() const;
 
 	virtual bool GetLastLoadModuleSuccess() const
@@ -117,6 +124,27 @@ public:
          return m_TotalLoadedModulesEver;
      }
  
+    virtual const ReloadReport& GetLastReloadReport() const
+    {
+        return m_LastReloadReport;
+    }
+
+    virtual void SetUnloadUnusedModules( bool bUnload_ )
+    {
+        m_bUnloadUnusedModules = bUnload_;
+    }
+    virtual bool GetUnloadUnusedModules() const
+    {
+        return m_bUnloadUnusedModules;
+    }
+    virtual void AddModuleReference(    IObjectConstructor* pConstructor_ );
+    virtual void RemoveModuleReference( IObjectConstructor* pConstructor_ );
+    virtual unsigned int UnloadUnusedModules();
+    virtual unsigned int GetNumberCurrentlyLoadedModules() const
+    {
+        return (unsigned int)m_Modules.size() + 1; // plus the exe
+    }
+
 	virtual void SetupObjectConstructors(IPerModuleInterface* pPerModuleInterface);
 
      // exception handling to catch and protect main app from crashing when using runtime compiling
@@ -138,6 +166,15 @@ public:
     virtual int TestBuildAllRuntimeHeaders(     ITestBuildNotifier* callback, bool bTestFileTracking );
 
 
+    virtual void SetTestBuildBatchSize( unsigned int numFiles_ )
+    {
+        m_TestBuildBatchSize = numFiles_;
+    }
+    virtual void SetTestBuildReport( const char* path_ )
+    {
+        m_TestBuildReportPath = path_ ? path_ : "";
+    }
+
     virtual bool TestBuildCallback(const char* file, TestBuildResult type);
     virtual bool TestBuildWaitAndUpdate();
 
@@ -164,6 +201,29 @@ private:
 	typedef std::pair<FileSystemUtils::Path,FileSystemUtils::Path>          TFileToFilePair;
 	typedef std::pair<TFileToFilesMap::iterator,TFileToFilesMap::iterator>  TFileToFilesEqualRange;
 
+	typedef std::unordered_set<std::string>                                 TFileKeySet;
+
+	// Many to many mapping between files and the files which depend on them, hashed in both
+	// directions on canonical path so lookups and removals do not scan every tracked file.
+	class FileDependencyIndex
+	{
+	public:
+		typedef std::unordered_map<std::string,FileSystemUtils::Path>       TFileSet;    // canonical key to path
+
+		void            Add( const FileSystemUtils::Path& file_, const FileSystemUtils::Path& dependent_ );
+		void            RemoveDependent( const FileSystemUtils::Path& dependent_ );
+		const TFileSet* GetDependents( const FileSystemUtils::Path& file_ ) const;  // NULL if none
+		const TFileSet* GetFiles( const FileSystemUtils::Path& dependent_ ) const;  // NULL if none
+
+	private:
+		typedef std::unordered_map<std::string,TFileSet>                    TFileToFileSetMap;
+		TFileToFileSetMap   m_FileToDependents;
+		TFileToFileSetMap   m_DependentToFiles;
+	};
+
+	// key used for hashed file lookups, clean path in OS canonical case
+	static std::string GetFileKey( const FileSystemUtils::Path& path_ );
+
 	// AddToRuntimeFileListImp & RemoveFromRuntimeFileList do not change filename to OS canonical case
     void AddToRuntimeFileListImp(      const FileSystemUtils::Path& filename, unsigned short projectId_ = 0 );
     void RemoveFromRuntimeFileListImp( const FileSystemUtils::Path& filename, unsigned short projectId_ = 0 );
@@ -181,7 +241,16 @@ private:
 
 	bool					m_bCompiling;
 	bool					m_bLastLoadModuleSuccess;
-	std::vector<HMODULE>	m_Modules;	// Stores runtime created modules, but not the exe module.
+	struct LoadedModule
+	{
+		HMODULE					module;
+		IPerModuleInterface*	pPerModuleInterface;
+		FileSystemUtils::Path	path;
+		int						references;			// added with AddModuleReference
+	};
+	std::vector<LoadedModule>	m_Modules;	// Stores runtime created modules, but not the exe module.
+	LoadedModule*			FindModule( IObjectConstructor* pConstructor_ );
+	bool					m_bUnloadUnusedModules;
 
 	bool					m_bAutoCompile;
 	FileSystemUtils::Path   m_CurrentlyCompilingModuleName;
@@ -193,14 +262,16 @@ private:
 		{
 			m_CompilerOptions.optimizationLevel = RCCPPOPTIMIZATIONLEVEL_DEFAULT;
 			m_CompilerOptions.baseIntermediatePath = ms_DefaultIntermediatePath;
+			m_CompilerOptions.maxParallelCompiles = 0;
 		}
 
 		CompilerOptions						m_CompilerOptions;
 
 		TFileList                           m_RuntimeFileList;
-        TFileToFilesMap                     m_RuntimeIncludeMap;
+        TFileKeySet                         m_RuntimeFileKeys;              // keys of m_RuntimeFileList for fast lookup
+        FileDependencyIndex                 m_RuntimeIncludeIndex;          // include file -> source files including it
         TFileToFilesMap			            m_RuntimeLinkLibraryMap;
-        TFileToFilesMap                     m_RuntimeSourceDependencyMap;
+        FileDependencyIndex                 m_RuntimeSourceDependencyIndex; // source dependency -> source files requiring it
 
         std::vector<BuildTool::FileToBuild> m_BuildFileList;
         std::vector<BuildTool::FileToBuild> m_PendingBuildFileList; // if a compile is already underway, store files here.
@@ -214,6 +285,55 @@ private:
     unsigned int            m_TotalLoadedModulesEver;
     bool                    m_bProtectionEnabled;
 
+    // reload timing
+    void                    CompleteReloadReport( bool bSucceeded_ );
+    ReloadReport            m_LastReloadReport;
+    ReloadReport            m_CurrentReloadReport;
+    TimePoint               m_ReloadStartTime;
+    TimePoint               m_FileChangeTime;
+    bool                    m_bHaveFileChangeTime;
+    TimePoint               m_CompileCompleteTime;
+    bool                    m_bHaveCompileCompleteTime;
+
+
+    // test builds
+    struct TestBuildReloadTimes
+    {
+        TestBuildReloadTimes()
+            : compileSeconds( 0.0 )
+            , linkSeconds( 0.0 )
+            , loadModuleSeconds( 0.0 )
+            , objectSwapSeconds( 0.0 )
+            , reloadSeconds( 0.0 )
+        {
+        }
+
+        double                                  compileSeconds;     // summed over the reloads of a test batch
+        double                                  linkSeconds;
+        double                                  loadModuleSeconds;
+        double                                  objectSwapSeconds;
+        double                                  reloadSeconds;
+        std::vector<CompileTimings::FileTiming> compileFiles;
+    };
+    struct TestBuildReportEntry
+    {
+        FileSystemUtils::Path   file;
+        unsigned int            batch;
+        TestBuildResult         result;
+        double                  fileCompileSeconds; // processes compiling this file, -ve if it was not compiled itself
+        TestBuildReloadTimes    times;
+    };
+    int                     TestBuildAllRuntimeFiles( ITestBuildNotifier* callback, bool bTestFileTracking, bool bHeaders );
+    int                     TestBuildBatch( const TFileList& files_, unsigned short projectId_,
+                                            ITestBuildNotifier* callback, bool bTestFileTracking );
+    bool                    TestBuildNotifyResults( ITestBuildNotifier* callback, const TFileList& files_,
+                                                    TestBuildResult type_, const TestBuildReloadTimes& times_ );
+    void                    WriteTestBuildReport( double totalSeconds_ ) const;
+    unsigned int            m_TestBuildBatchSize;
+    unsigned int            m_TestBuildBatch;
+    FileSystemUtils::Path   m_TestBuildReportPath;
+    std::vector<TestBuildReportEntry> m_TestBuildReport;
+
 
     // File mappings - we need to map from compiled path to a potentially different path
     // on the system the code is running on
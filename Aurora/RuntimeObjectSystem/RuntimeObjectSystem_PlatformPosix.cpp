@@ -29,9 +29,37 @@
 #include <assert.h>
 #include <signal.h>
 #include <string.h>
+#include <stdlib.h>
 
 static __thread RuntimeProtector*   m_pCurrProtector    = 0; // for nested threaded handling, one per thread.
 
+// Signal handlers are installed once per process rather than on each protected call, and pass signals
+// raised outside protected functions to the previous handlers. SA_NODEFER leaves the signal unblocked
+// when longjmp leaves the handler, so the signal mask need not be saved and restored.
+static const int                    PROTECTED_SIGNALS[]     = { SIGILL, SIGBUS, SIGSEGV };
+static const int                    NUM_PROTECTED_SIGNALS   = sizeof( PROTECTED_SIGNALS ) / sizeof( PROTECTED_SIGNALS[0] );
+static struct sigaction             ms_OldActions[ NUM_PROTECTED_SIGNALS ];
+static pthread_once_t               ms_SignalHandlersOnce   = PTHREAD_ONCE_INIT;
+
+// Each thread using protection gets an alternate signal stack, so stack overflows can be caught.
+struct SignalStack
+{
+    void* pStack;
+    SignalStack() : pStack( 0 ) {}
+    ~SignalStack()
+    {
+        if( pStack )
+        {
+            stack_t altStack;
+            memset( &altStack, 0, sizeof( altStack ) );
+            altStack.ss_flags = SS_DISABLE;
+            sigaltstack( &altStack, NULL );
+            free( pStack );
+        }
+    }
+};
+static thread_local SignalStack     ms_SignalStack;
+
 #ifdef __APPLE__
 	static bool                         ms_bMachPortSet     = false;
 
@@ -83,11 +111,44 @@ void RuntimeObjectSystem::SetProtectionEnabled( bool bProtectionEnabled_ )
 
 
 
+static void CallPreviousSignalHandler( int sig, siginfo_t *info, void *context )
+{
+    for( int i = 0; i < NUM_PROTECTED_SIGNALS; ++i )
+    {
+        if( PROTECTED_SIGNALS[i] != sig )
+        {
+            continue;
+        }
+        const struct sigaction& oldAction = ms_OldActions[i];
+        if( oldAction.sa_flags & SA_SIGINFO )
+        {
+            oldAction.sa_sigaction( sig, info, context );
+        }
+        else if( oldAction.sa_handler != SIG_DFL && oldAction.sa_handler != SIG_IGN )
+        {
+            oldAction.sa_handler( sig );
+        }
+        else
+        {
+            // restore the default action, which terminates the process
+            struct sigaction defaultAction;
+            memset( &defaultAction, 0, sizeof( defaultAction ));
+            defaultAction.sa_handler = SIG_DFL;
+            sigaction( sig, &defaultAction, NULL );
+            raise( sig );
+        }
+        return;
+    }
+}
+
 void signalHandler(int sig, siginfo_t *info, void *context)
 {
-    (void) context;
     // we only handle synchronous signals with this handler, so they come to the correct thread.
-    assert( m_pCurrProtector );
+    if( !m_pCurrProtector )
+    {
+        CallPreviousSignalHandler( sig, info, context );
+        return;
+    }
     
     // store exception information
     switch( sig )
@@ -104,7 +165,40 @@ void signalHandler(int sig, siginfo_t *info, void *context)
         default: assert(false); //should not get here
     }
     m_pCurrProtector->ExceptionInfo.Addr = info->si_addr;
-    longjmp(m_pCurrProtector->m_env, sig );
+    _longjmp(m_pCurrProtector->m_env, sig );
+}
+
+static void InstallSignalHandlers()
+{
+    struct sigaction newAction;
+    memset( &newAction, 0, sizeof( newAction ));
+    newAction.sa_sigaction = signalHandler;
+    newAction.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER; //use complex signal hander function sa_sigaction not sa_handler
+    for( int i = 0; i < NUM_PROTECTED_SIGNALS; ++i )
+    {
+        sigaction( PROTECTED_SIGNALS[i], &newAction, &ms_OldActions[i] );
+    }
+}
+
+static void SetupSignalHandling()
+{
+    pthread_once( &ms_SignalHandlersOnce, InstallSignalHandlers );
+    if( !ms_SignalStack.pStack )
+    {
+        size_t stackSize = SIGSTKSZ > 64 * 1024 ? SIGSTKSZ : 64 * 1024;
+        stack_t altStack;
+        memset( &altStack, 0, sizeof( altStack ) );
+        altStack.ss_sp = malloc( stackSize );
+        altStack.ss_size = stackSize;
+        if( altStack.ss_sp && 0 == sigaltstack( &altStack, NULL ) )
+        {
+            ms_SignalStack.pStack = altStack.ss_sp;
+        }
+        else
+        {
+            free( altStack.ss_sp ); // handled on the thread's stack
+        }
+    }
 }
 
 bool RuntimeObjectSystem::TryProtectedFunction( RuntimeProtector* pProtectedObject_ )
@@ -115,11 +209,11 @@ bool RuntimeObjectSystem::TryProtectedFunction( RuntimeProtector* pProtectedObje
        return true;
    }
     
+    SetupSignalHandling();
+
     // allow cascading by storing prev and current impl
     pProtectedObject_->m_pPrevious         = m_pCurrProtector;
     m_pCurrProtector                       = pProtectedObject_;
- 
-    struct sigaction oldAction[3]; // we need to store old actions, could remove for optimization
 
     bool bHasJustHadException = false;
     if( m_TotalLoadedModulesEver != pProtectedObject_->m_ModulesLoadedCount )
@@ -131,28 +225,16 @@ bool RuntimeObjectSystem::TryProtectedFunction( RuntimeProtector* pProtectedObje
 
     if( !pProtectedObject_->m_bHashadException )
     {
-        if( setjmp(m_pCurrProtector->m_env) )
+        // _setjmp does not save the signal mask, avoiding a syscall
+        if( _setjmp(m_pCurrProtector->m_env) )
         {
             pProtectedObject_->m_bHashadException = true;
             bHasJustHadException = true;
         }
         else
         {
-            struct sigaction newAction;
-            memset( &newAction, 0, sizeof( newAction ));
-            newAction.sa_sigaction = signalHandler;
-            newAction.sa_flags = SA_SIGINFO; //use complex signal hander function sa_sigaction not sa_handler
-            sigaction(SIGILL, &newAction, &oldAction[0] );
-            sigaction(SIGBUS, &newAction, &oldAction[1] );
-            sigaction(SIGSEGV, &newAction, &oldAction[2] );
-                
             pProtectedObject_->ProtectedFunc();
         }
-        
-        //reset
-        sigaction(SIGILL, &oldAction[0], NULL );
-        sigaction(SIGBUS, &oldAction[1], NULL );
-        sigaction(SIGSEGV, &oldAction[2], NULL );
     }
     m_pCurrProtector = pProtectedObject_->m_pPrevious;
     return !bHasJustHadException;
@@ -161,7 +243,15 @@ bool RuntimeObjectSystem::TryProtectedFunction( RuntimeProtector* pProtectedObje
 
 bool RuntimeObjectSystem::TestBuildWaitAndUpdate()
 {
-    usleep( 100 * 1000 );
+    if( m_bCompiling )
+    {
+        m_pBuildTool->WaitForComplete( 100 );
+    }
+    else
+    {
+        // waiting for file change detection
+        usleep( 100 * 1000 );
+    }
     return true;
 }
 
@@ -193,7 +193,15 @@ bool RuntimeObjectSystem::TryProtectedFunction( RuntimeProtector* pProtectedObje
 
 bool RuntimeObjectSystem::TestBuildWaitAndUpdate()
 {
-    Sleep( 100 );
+    if( m_bCompiling )
+    {
+        m_pBuildTool->WaitForComplete( 100 );
+    }
+    else
+    {
+        // waiting for file change detection
+        Sleep( 100 );
+    }
     MSG msg;
     while( PeekMessage( &msg, NULL, 0, 0, PM_REMOVE ) )
     {
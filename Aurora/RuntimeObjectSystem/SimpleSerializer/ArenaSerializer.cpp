@@ -0,0 +1,859 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "ArenaSerializer.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "../../RuntimeObjectSystem/IObject.h"
+
+// blocks are at least this size, larger values get their own block
+static const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+// alignment of value copies, which are only accessed via memcpy
+static const size_t ARENA_DATA_ALIGNMENT = 8;
+
+static const unsigned int SCHEMA_HASH_BASIS = 2166136261u;
+
+// snapshot files start with this, followed by the version
+static const char SNAPSHOT_MAGIC[4] = { 'R', 'C', 'C', 'S' };
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+static bool IsArithmeticType( SerializedTypeId type_ )
+{
+	return type_ != SERIALIZEDTYPE_UNKNOWN && type_ < SERIALIZEDTYPE_ARITHMETIC_END;
+}
+
+static bool IsIntegralType( SerializedTypeId type_ )
+{
+	return type_ >= SERIALIZEDTYPE_BOOL && type_ <= SERIALIZEDTYPE_UNSIGNED_LONG_LONG;
+}
+
+static bool IsSignedType( SerializedTypeId type_ )
+{
+	switch( type_ )
+	{
+	case SERIALIZEDTYPE_CHAR:			return (char)-1 < 0;
+	case SERIALIZEDTYPE_SIGNED_CHAR:
+	case SERIALIZEDTYPE_SHORT:
+	case SERIALIZEDTYPE_INT:
+	case SERIALIZEDTYPE_LONG:
+	case SERIALIZEDTYPE_LONG_LONG:		return true;
+	default:							return !IsIntegralType( type_ );
+	}
+}
+
+#define ARENA_CASE_READ( ID, T ) case ID: { T value; memcpy( &value, pSrc_, sizeof( T ) ); return (R)value; }
+#define ARENA_CASE_WRITE( ID, T ) case ID: { T value = (T)value_; memcpy( pDst_, &value, sizeof( T ) ); return; }
+
+template<typename R> static R ReadArithmetic( SerializedTypeId type_, const void* pSrc_ )
+{
+	switch( type_ )
+	{
+	ARENA_CASE_READ( SERIALIZEDTYPE_BOOL,				bool )
+	ARENA_CASE_READ( SERIALIZEDTYPE_CHAR,				char )
+	ARENA_CASE_READ( SERIALIZEDTYPE_SIGNED_CHAR,		signed char )
+	ARENA_CASE_READ( SERIALIZEDTYPE_UNSIGNED_CHAR,		unsigned char )
+	ARENA_CASE_READ( SERIALIZEDTYPE_SHORT,				short )
+	ARENA_CASE_READ( SERIALIZEDTYPE_UNSIGNED_SHORT,		unsigned short )
+	ARENA_CASE_READ( SERIALIZEDTYPE_INT,				int )
+	ARENA_CASE_READ( SERIALIZEDTYPE_UNSIGNED_INT,		unsigned int )
+	ARENA_CASE_READ( SERIALIZEDTYPE_LONG,				long )
+	ARENA_CASE_READ( SERIALIZEDTYPE_UNSIGNED_LONG,		unsigned long )
+	ARENA_CASE_READ( SERIALIZEDTYPE_LONG_LONG,			long long )
+	ARENA_CASE_READ( SERIALIZEDTYPE_UNSIGNED_LONG_LONG,	unsigned long long )
+	ARENA_CASE_READ( SERIALIZEDTYPE_FLOAT,				float )
+	ARENA_CASE_READ( SERIALIZEDTYPE_DOUBLE,				double )
+	ARENA_CASE_READ( SERIALIZEDTYPE_LONG_DOUBLE,		long double )
+	default: return R( 0 );
+	}
+}
+
+template<typename V> static void WriteArithmetic( SerializedTypeId type_, V value_, void* pDst_ )
+{
+	switch( type_ )
+	{
+	case SERIALIZEDTYPE_BOOL: { bool value = value_ != V( 0 ); memcpy( pDst_, &value, sizeof( bool ) ); return; }
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_CHAR,				char )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_SIGNED_CHAR,		signed char )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_UNSIGNED_CHAR,		unsigned char )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_SHORT,				short )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_UNSIGNED_SHORT,	unsigned short )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_INT,				int )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_UNSIGNED_INT,		unsigned int )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_LONG,				long )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_UNSIGNED_LONG,		unsigned long )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_LONG_LONG,			long long )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_UNSIGNED_LONG_LONG,unsigned long long )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_FLOAT,				float )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_DOUBLE,			double )
+	ARENA_CASE_WRITE( SERIALIZEDTYPE_LONG_DOUBLE,		long double )
+	default: return;
+	}
+}
+
+#undef ARENA_CASE_READ
+#undef ARENA_CASE_WRITE
+
+// converts between arithmetic types as a static_cast would, integers are converted without passing
+// through floating point so 64 bit values are preserved
+static void ConvertArithmetic( SerializedTypeId srcType_, const void* pSrc_, SerializedTypeId dstType_, void* pDst_ )
+{
+	if( IsIntegralType( srcType_ ) && IsIntegralType( dstType_ ) )
+	{
+		if( IsSignedType( srcType_ ) )
+		{
+			WriteArithmetic( dstType_, ReadArithmetic<long long>( srcType_, pSrc_ ), pDst_ );
+		}
+		else
+		{
+			WriteArithmetic( dstType_, ReadArithmetic<unsigned long long>( srcType_, pSrc_ ), pDst_ );
+		}
+	}
+	else
+	{
+		WriteArithmetic( dstType_, ReadArithmetic<long double>( srcType_, pSrc_ ), pDst_ );
+	}
+}
+
+ArenaSerializer::ArenaSerializer()
+	: m_CurrentBlock( 0 )
+	, m_CurrentBlockUsed( 0 )
+	, m_bSorted( true )
+	, m_bLoading( false )
+	, m_pCurrentObject( 0 )
+	, m_CurrentRecord( InvalidId )
+	, m_pCurrentLoadRecord( 0 )
+	, m_pCurrentTypeNames( 0 )
+	, m_CurrentSchemaHash( 0 )
+	, m_bHashCurrentSchema( false )
+	, m_pSnapshotCursor( 0 )
+	, m_pSnapshotEnd( 0 )
+	, m_NumSnapshotTypes( 0 )
+{
+}
+
+ArenaSerializer::~ArenaSerializer()
+{
+	Clear();
+	for( size_t i = 0; i < m_Blocks.size(); ++i )
+	{
+		free( m_Blocks[i].pData );
+	}
+}
+
+void ArenaSerializer::Clear()
+{
+	for( size_t i = 0; i < m_Properties.size(); ++i )
+	{
+		if( m_Properties[i].pValue )
+		{
+			m_Properties[i].pValue->~ISerializedValue();
+		}
+	}
+	m_Properties.clear();
+	m_Objects.clear();
+	m_SortedObjects.clear();
+	m_TypeNames.clear();
+	m_bSorted = true;
+	m_pCurrentObject = 0;
+	m_CurrentRecord = InvalidId;
+	m_pCurrentLoadRecord = 0;
+	m_pCurrentTypeNames = 0;
+	m_pSnapshotCursor = 0;
+	m_pSnapshotEnd = 0;
+	m_NumSnapshotTypes = 0;
+
+	// keep the first block for reuse
+	for( size_t i = 1; i < m_Blocks.size(); ++i )
+	{
+		free( m_Blocks[i].pData );
+	}
+	if( m_Blocks.size() > 1 )
+	{
+		m_Blocks.resize( 1 );
+	}
+	m_CurrentBlock = 0;
+	m_CurrentBlockUsed = 0;
+}
+
+void ArenaSerializer::Clear(ObjectId ownerId)
+{
+	for( size_t i = 0; i < m_Objects.size(); ++i )
+	{
+		ObjectRecord& record = m_Objects[i];
+		if( record.id == ownerId )
+		{
+			for( size_t prop = record.firstProperty; prop < record.firstProperty + record.numProperties; ++prop )
+			{
+				if( m_Properties[ prop ].pValue )
+				{
+					m_Properties[ prop ].pValue->~ISerializedValue();
+					m_Properties[ prop ].pValue = 0;
+				}
+				m_Properties[ prop ].pData = 0;
+			}
+		}
+	}
+}
+
+void ArenaSerializer::Clear(ObjectId ownerId, const char* propertyName)
+{
+	if( ownerId.m_ConstructorId >= m_TypeNames.size() )
+	{
+		return;
+	}
+	TypeNames& typeNames = m_TypeNames[ ownerId.m_ConstructorId ];
+	for( size_t i = 0; i < m_Objects.size(); ++i )
+	{
+		ObjectRecord& record = m_Objects[i];
+		if( record.id == ownerId )
+		{
+			for( size_t prop = record.firstProperty; prop < record.firstProperty + record.numProperties; ++prop )
+			{
+				PropertyRecord& property = m_Properties[ prop ];
+				if( ( property.pValue || property.pData ) && 0 == strcmp( typeNames.names[ property.name ], propertyName ) )
+				{
+					if( property.pValue )
+					{
+						property.pValue->~ISerializedValue();
+						property.pValue = 0;
+					}
+					property.pData = 0;
+				}
+			}
+		}
+	}
+}
+
+void ArenaSerializer::SetIsLoading( bool loading )
+{
+	m_bLoading = loading;
+	m_pCurrentObject = 0;
+	if( m_bLoading && !m_bSorted )
+	{
+		SortObjects();
+	}
+}
+
+void ArenaSerializer::Serialize( IObject* pObject )
+{
+	assert( pObject );
+	assert( 0 == m_pCurrentObject );	//should not serialize an object from within another
+
+	m_pCurrentObject = pObject;
+	ObjectId ownerId;
+	m_pCurrentObject->GetObjectId(ownerId);
+
+	if( ownerId.m_ConstructorId >= m_TypeNames.size() )
+	{
+		m_TypeNames.resize( ownerId.m_ConstructorId + 1 );
+	}
+	m_pCurrentTypeNames = &m_TypeNames[ ownerId.m_ConstructorId ];
+	m_CurrentSchemaHash = SCHEMA_HASH_BASIS;
+
+	if( m_bLoading )
+	{
+		m_pCurrentLoadRecord = FindObject( ownerId );
+		m_bHashCurrentSchema = m_pCurrentLoadRecord && !m_pCurrentTypeNames->bLoadSchemaSet;
+	}
+	else
+	{
+		// objects are usually serialized in ObjectId order, so the index stays sorted
+		if( m_Objects.size() && !( m_Objects.back().id < ownerId ) )
+		{
+			m_bSorted = false;
+		}
+		ObjectRecord record = { ownerId, m_Properties.size(), 0 };
+		m_CurrentRecord = m_Objects.size();
+		m_Objects.push_back( record );
+		m_bHashCurrentSchema = !m_pCurrentTypeNames->bSaveSchemaSet;
+	}
+
+	m_pCurrentObject->Serialize( this );
+
+	// the schema of a type is taken from its first object, as objects of a type serialize the same properties
+	if( m_bHashCurrentSchema )
+	{
+		if( m_bLoading )
+		{
+			m_pCurrentTypeNames->loadSchemaHash = m_CurrentSchemaHash;
+			m_pCurrentTypeNames->bLoadSchemaSet = true;
+		}
+		else
+		{
+			m_pCurrentTypeNames->saveSchemaHash = m_CurrentSchemaHash;
+			m_pCurrentTypeNames->bSaveSchemaSet = true;
+		}
+		m_bHashCurrentSchema = false;
+	}
+
+	//reset current object
+	m_pCurrentObject = 0;
+	m_CurrentRecord = InvalidId;
+	m_pCurrentLoadRecord = 0;
+	m_pCurrentTypeNames = 0;
+}
+
+void* ArenaSerializer::AllocateValue( size_t size_, size_t alignment_ )
+{
+	return Allocate( size_, alignment_ );
+}
+
+void ArenaSerializer::SetISerializedValue(const char* propertyName, const ISerializedValue* pValue)
+{
+	assert( m_pCurrentObject );
+	assert( pValue );
+	assert( !m_bLoading );
+
+	// properties of an object are contiguous as objects do not serialize within each other
+	ObjectRecord& record = m_Objects[ m_CurrentRecord ];
+	assert( record.firstProperty + record.numProperties == m_Properties.size() );
+	PropertyRecord property = { GetPropertyName( propertyName, true ), pValue, NULL, SERIALIZEDTYPE_UNKNOWN, 0 };
+	m_Properties.push_back( property );
+	++record.numProperties;
+}
+
+const ISerializedValue* ArenaSerializer::GetISerializedValue(const char* propertyName) const
+{
+	assert( m_pCurrentObject );
+	assert( propertyName );
+	assert( m_bLoading );
+
+	const PropertyRecord* pProperty = FindProperty( propertyName );
+	return pProperty ? pProperty->pValue : NULL;
+}
+
+void ArenaSerializer::SetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, const void* pData_, const ISerializedValue* pValue_ )
+{
+	assert( m_pCurrentObject );
+	assert( pData_ || pValue_ );
+	assert( !m_bLoading );
+
+	ObjectRecord& record = m_Objects[ m_CurrentRecord ];
+	assert( record.firstProperty + record.numProperties == m_Properties.size() );
+	void* pCopy = NULL;
+	if( pData_ )
+	{
+		pCopy = Allocate( size_, ARENA_DATA_ALIGNMENT );
+		memcpy( pCopy, pData_, size_ );
+	}
+	PropertyRecord property = { GetPropertyName( propertyName, true ), pValue_, pCopy, type_, size_ };
+	m_Properties.push_back( property );
+	++record.numProperties;
+
+	if( m_bHashCurrentSchema )
+	{
+		m_CurrentSchemaHash = HashSchemaEntry( m_CurrentSchemaHash, propertyName, type_, size_ );
+	}
+}
+
+bool ArenaSerializer::GetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, void* pData_, const ISerializedValue** ppValue_ ) const
+{
+	assert( m_pCurrentObject );
+	assert( propertyName );
+	assert( m_bLoading );
+
+	if( m_bHashCurrentSchema )
+	{
+		m_CurrentSchemaHash = HashSchemaEntry( m_CurrentSchemaHash, propertyName, type_, size_ );
+	}
+
+	const PropertyRecord* pProperty = FindProperty( propertyName );
+	if( !pProperty || !( pProperty->pData || pProperty->pValue ) )
+	{
+		return false;	// new or cleared property
+	}
+
+	if( pProperty->type == type_ && pProperty->size == size_ )
+	{
+		if( pData_ && pProperty->pData )
+		{
+			memcpy( pData_, pProperty->pData, size_ );
+			return true;
+		}
+		if( ppValue_ && pProperty->pValue )
+		{
+			*ppValue_ = pProperty->pValue;
+			return true;
+		}
+	}
+	else if( pData_ && pProperty->pData && IsArithmeticType( type_ ) && IsArithmeticType( pProperty->type ) )
+	{
+		ConvertArithmetic( pProperty->type, pProperty->pData, type_, pData_ );
+		++m_pCurrentTypeNames->numConverted;
+		return true;
+	}
+
+	// the type of the property has changed, leave the value as constructed
+	++m_pCurrentTypeNames->numSkipped;
+	return false;
+}
+
+const ArenaSerializer::PropertyRecord* ArenaSerializer::FindProperty( const char* propertyName ) const
+{
+	if( !m_pCurrentLoadRecord )
+	{
+		return NULL;
+	}
+	unsigned int name = const_cast<ArenaSerializer*>( this )->GetPropertyName( propertyName, false );
+	if( InvalidName == name )
+	{
+		return NULL;
+	}
+
+	// search backwards so a property set more than once returns the last value
+	size_t first = m_pCurrentLoadRecord->firstProperty;
+	for( size_t prop = first + m_pCurrentLoadRecord->numProperties; prop > first; --prop )
+	{
+		const PropertyRecord& property = m_Properties[ prop - 1 ];
+		if( property.name == name )
+		{
+			return &property;
+		}
+	}
+	return NULL;
+}
+
+unsigned int ArenaSerializer::HashSchemaEntry( unsigned int hash_, const char* propertyName, SerializedTypeId type_, size_t size_ )
+{
+	for( ; *propertyName; ++propertyName )
+	{
+		hash_ = ( hash_ ^ (unsigned char)*propertyName ) * 16777619u;
+	}
+	hash_ = ( hash_ ^ type_ ) * 16777619u;
+	hash_ = ( hash_ ^ (unsigned int)size_ ) * 16777619u;
+	return hash_;
+}
+
+ArenaSerializer::SchemaChanges ArenaSerializer::GetSchemaChanges( ConstructorId constructorId_ ) const
+{
+	SchemaChanges changes = { false, 0, 0 };
+	if( constructorId_ < m_TypeNames.size() )
+	{
+		const TypeNames& typeNames = m_TypeNames[ constructorId_ ];
+		changes.bSchemaChanged = typeNames.bSaveSchemaSet && typeNames.bLoadSchemaSet && typeNames.saveSchemaHash != typeNames.loadSchemaHash;
+		changes.numConverted   = typeNames.numConverted;
+		changes.numSkipped     = typeNames.numSkipped;
+	}
+	return changes;
+}
+
+unsigned int ArenaSerializer::GetPropertyName( const char* propertyName, bool bAdd )
+{
+	TypeNames& typeNames = *m_pCurrentTypeNames;
+	std::unordered_map<const char*,unsigned int>::iterator found = typeNames.literalToName.find( propertyName );
+	if( found != typeNames.literalToName.end() && ( InvalidName != found->second || !bAdd ) )
+	{
+		return found->second;
+	}
+
+	// new pointer, names are per type so this search is short
+	unsigned int name = InvalidName;
+	for( size_t i = 0; i < typeNames.names.size(); ++i )
+	{
+		if( 0 == strcmp( typeNames.names[i], propertyName ) )
+		{
+			name = (unsigned int)i;
+			break;
+		}
+	}
+	if( InvalidName == name && bAdd )
+	{
+		size_t length = strlen( propertyName ) + 1;
+		char* pCopy = (char*)Allocate( length, 1 );
+		memcpy( pCopy, propertyName, length );
+		name = (unsigned int)typeNames.names.size();
+		typeNames.names.push_back( pCopy );
+	}
+	if( InvalidName != name || !bAdd )
+	{
+		typeNames.literalToName[ propertyName ] = name;
+	}
+	return name;
+}
+
+const ArenaSerializer::ObjectRecord* ArenaSerializer::FindObject( ObjectId id_ ) const
+{
+	if( m_bSorted )
+	{
+		// records are in order, find the last with this id
+		const ObjectRecord* pBegin = m_Objects.empty() ? 0 : &m_Objects[0];
+		size_t count = m_Objects.size();
+		const ObjectRecord* pFirst = pBegin;
+		while( count > 0 )
+		{
+			size_t step = count / 2;
+			const ObjectRecord* pMid = pFirst + step;
+			if( !( id_ < pMid->id ) )
+			{
+				pFirst = pMid + 1;
+				count -= step + 1;
+			}
+			else
+			{
+				count = step;
+			}
+		}
+		if( pFirst != pBegin && ( pFirst - 1 )->id == id_ )
+		{
+			return pFirst - 1;
+		}
+		return NULL;
+	}
+
+	size_t count = m_SortedObjects.size();
+	size_t first = 0;
+	while( count > 0 )
+	{
+		size_t step = count / 2;
+		size_t mid = first + step;
+		if( !( id_ < m_Objects[ m_SortedObjects[ mid ] ].id ) )
+		{
+			first = mid + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+	if( first > 0 && m_Objects[ m_SortedObjects[ first - 1 ] ].id == id_ )
+	{
+		return &m_Objects[ m_SortedObjects[ first - 1 ] ];
+	}
+	return NULL;
+}
+
+struct ArenaSerializerCompareRecords
+{
+	const std::vector<ObjectId>* pIds;
+	bool operator()( size_t lhs, size_t rhs ) const
+	{
+		return (*pIds)[ lhs ] < (*pIds)[ rhs ];
+	}
+};
+
+void ArenaSerializer::SortObjects()
+{
+	std::vector<ObjectId> ids( m_Objects.size() );
+	m_SortedObjects.resize( m_Objects.size() );
+	for( size_t i = 0; i < m_Objects.size(); ++i )
+	{
+		ids[i] = m_Objects[i].id;
+		m_SortedObjects[i] = i;
+	}
+	// stable so the last record for an ObjectId remains last
+	ArenaSerializerCompareRecords compare = { &ids };
+	std::stable_sort( m_SortedObjects.begin(), m_SortedObjects.end(), compare );
+}
+
+void* ArenaSerializer::Allocate( size_t size_, size_t alignment_ )
+{
+	while( true )
+	{
+		if( m_CurrentBlock < m_Blocks.size() )
+		{
+			Block& block = m_Blocks[ m_CurrentBlock ];
+			size_t address = (size_t)( block.pData + m_CurrentBlockUsed );
+			size_t aligned = ( address + alignment_ - 1 ) & ~( alignment_ - 1 );
+			size_t end = aligned - (size_t)block.pData + size_;
+			if( end <= block.size )
+			{
+				m_CurrentBlockUsed = end;
+				return (void*)aligned;
+			}
+			if( m_CurrentBlock + 1 < m_Blocks.size() )
+			{
+				++m_CurrentBlock;
+				m_CurrentBlockUsed = 0;
+				continue;
+			}
+		}
+
+		Block block;
+		block.size = std::max( ARENA_BLOCK_SIZE, size_ + alignment_ );
+		block.pData = (char*)malloc( block.size );
+		m_CurrentBlock = m_Blocks.size();
+		m_CurrentBlockUsed = 0;
+		m_Blocks.push_back( block );
+	}
+}
+
+// Snapshot layout, in the byte order of the saving machine:
+//   magic, uint32 version, uint32 numTypes
+//   per type:   uint32 nameLength, name with terminator
+//   per type:   uint32 numPropertyNames, per name: uint32 nameLength, name with terminator
+//               uint32 numObjects, per object: uint64 perTypeId, uint32 numProperties,
+//               per property: uint32 name, uint32 type, uint32 size, value
+static bool WriteUint32( FILE* pFile_, uint32_t value_ )
+{
+	return 1 == fwrite( &value_, sizeof( value_ ), 1, pFile_ );
+}
+
+static bool WriteString( FILE* pFile_, const char* string_ )
+{
+	uint32_t length = (uint32_t)strlen( string_ ) + 1;
+	return WriteUint32( pFile_, length ) && 1 == fwrite( string_, length, 1, pFile_ );
+}
+
+static bool ReadBytes( const char*& pCursor_, const char* pEnd_, void* pOut_, size_t size_ )
+{
+	if( (size_t)( pEnd_ - pCursor_ ) < size_ )
+	{
+		return false;
+	}
+	memcpy( pOut_, pCursor_, size_ );
+	pCursor_ += size_;
+	return true;
+}
+
+static bool ReadUint32( const char*& pCursor_, const char* pEnd_, uint32_t& value_ )
+{
+	return ReadBytes( pCursor_, pEnd_, &value_, sizeof( value_ ) );
+}
+
+// returns a pointer to the string in the snapshot data, NULL if invalid
+static const char* ReadString( const char*& pCursor_, const char* pEnd_ )
+{
+	uint32_t length = 0;
+	if( !ReadUint32( pCursor_, pEnd_, length ) || 0 == length || (size_t)( pEnd_ - pCursor_ ) < length || pCursor_[ length - 1 ] )
+	{
+		return NULL;
+	}
+	const char* pString = pCursor_;
+	pCursor_ += length;
+	return pString;
+}
+
+static bool IsSnapshotProperty( SerializedTypeId type_, const void* pData_ )
+{
+	return pData_ && SERIALIZEDTYPE_UNKNOWN != type_ && !( type_ & SERIALIZEDTYPE_POINTER_BIT );
+}
+
+bool ArenaSerializer::SaveSnapshot( FILE* pFile_, const std::vector<const char*>& typeNames_, size_t& numSkipped_ ) const
+{
+	assert( m_bLoading );
+	numSkipped_ = 0;
+
+	bool bOk = 1 == fwrite( SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ), 1, pFile_ );
+	bOk = bOk && WriteUint32( pFile_, SNAPSHOT_VERSION );
+	bOk = bOk && WriteUint32( pFile_, (uint32_t)typeNames_.size() );
+	for( size_t type = 0; bOk && type < typeNames_.size(); ++type )
+	{
+		bOk = WriteString( pFile_, typeNames_[ type ] );
+	}
+
+	// objects are in ObjectId order, so each type's objects are contiguous
+	size_t sortedIndex = 0;
+	for( size_t type = 0; bOk && type < typeNames_.size(); ++type )
+	{
+		size_t numNames = type < m_TypeNames.size() ? m_TypeNames[ type ].names.size() : 0;
+		bOk = WriteUint32( pFile_, (uint32_t)numNames );
+		for( size_t name = 0; bOk && name < numNames; ++name )
+		{
+			bOk = WriteString( pFile_, m_TypeNames[ type ].names[ name ] );
+		}
+
+		while( sortedIndex < m_Objects.size() && GetSortedObject( sortedIndex ).id.m_ConstructorId < type )
+		{
+			++sortedIndex;
+		}
+		size_t endIndex = sortedIndex;
+		uint32_t numObjects = 0;
+		while( endIndex < m_Objects.size() && GetSortedObject( endIndex ).id.m_ConstructorId == type )
+		{
+			if( endIndex + 1 == m_Objects.size() || !( GetSortedObject( endIndex + 1 ).id == GetSortedObject( endIndex ).id ) )
+			{
+				++numObjects;
+			}
+			++endIndex;
+		}
+		bOk = bOk && WriteUint32( pFile_, numObjects );
+
+		for( ; bOk && sortedIndex < endIndex; ++sortedIndex )
+		{
+			// only the last record for an ObjectId is used
+			const ObjectRecord& record = GetSortedObject( sortedIndex );
+			if( sortedIndex + 1 < endIndex && GetSortedObject( sortedIndex + 1 ).id == record.id )
+			{
+				continue;
+			}
+
+			uint32_t numProperties = 0;
+			for( size_t prop = record.firstProperty; prop < record.firstProperty + record.numProperties; ++prop )
+			{
+				const PropertyRecord& property = m_Properties[ prop ];
+				if( IsSnapshotProperty( property.type, property.pData ) )
+				{
+					++numProperties;
+				}
+				else if( property.pData || property.pValue )
+				{
+					++numSkipped_;
+				}
+			}
+
+			uint64_t perTypeId = record.id.m_PerTypeId;
+			bOk = 1 == fwrite( &perTypeId, sizeof( perTypeId ), 1, pFile_ );
+			bOk = bOk && WriteUint32( pFile_, numProperties );
+			for( size_t prop = record.firstProperty; bOk && prop < record.firstProperty + record.numProperties; ++prop )
+			{
+				const PropertyRecord& property = m_Properties[ prop ];
+				if( IsSnapshotProperty( property.type, property.pData ) )
+				{
+					bOk = WriteUint32( pFile_, property.name ) && WriteUint32( pFile_, property.type ) && WriteUint32( pFile_, (uint32_t)property.size )
+						&& ( 0 == property.size || 1 == fwrite( property.pData, property.size, 1, pFile_ ) );
+				}
+			}
+		}
+	}
+	return bOk;
+}
+
+bool ArenaSerializer::OpenSnapshot( const char* pData_, uint64_t size_, std::vector<const char*>& typeNames_ )
+{
+	Clear();
+	typeNames_.clear();
+	m_pSnapshotCursor = pData_;
+	m_pSnapshotEnd = pData_ + size_;
+
+	char magic[ sizeof( SNAPSHOT_MAGIC ) ];
+	uint32_t version = 0;
+	uint32_t numTypes = 0;
+	if( !ReadBytes( m_pSnapshotCursor, m_pSnapshotEnd, magic, sizeof( magic ) ) || 0 != memcmp( magic, SNAPSHOT_MAGIC, sizeof( magic ) )
+		|| !ReadUint32( m_pSnapshotCursor, m_pSnapshotEnd, version ) || SNAPSHOT_VERSION != version
+		|| !ReadUint32( m_pSnapshotCursor, m_pSnapshotEnd, numTypes ) )
+	{
+		return false;
+	}
+	for( uint32_t type = 0; type < numTypes; ++type )
+	{
+		const char* pName = ReadString( m_pSnapshotCursor, m_pSnapshotEnd );
+		if( !pName )
+		{
+			typeNames_.clear();
+			return false;
+		}
+		typeNames_.push_back( pName );
+	}
+	m_NumSnapshotTypes = numTypes;
+	return true;
+}
+
+bool ArenaSerializer::LoadSnapshot( const std::vector<ConstructorId>& constructorIds_, std::vector<ObjectId>& objectIds_ )
+{
+	assert( constructorIds_.size() == m_NumSnapshotTypes );
+	assert( !m_bLoading );
+	objectIds_.clear();
+
+	const char*& pCursor = m_pSnapshotCursor;
+	for( size_t type = 0; type < m_NumSnapshotTypes; ++type )
+	{
+		ConstructorId constructorId = constructorIds_[ type ];
+		if( InvalidId != constructorId && constructorId >= m_TypeNames.size() )
+		{
+			m_TypeNames.resize( constructorId + 1 );
+		}
+
+		uint32_t numNames = 0;
+		if( !ReadUint32( pCursor, m_pSnapshotEnd, numNames ) )
+		{
+			return false;
+		}
+		for( uint32_t name = 0; name < numNames; ++name )
+		{
+			const char* pName = ReadString( pCursor, m_pSnapshotEnd );
+			if( !pName )
+			{
+				return false;
+			}
+			if( InvalidId != constructorId )
+			{
+				m_TypeNames[ constructorId ].names.push_back( pName );
+			}
+		}
+
+		uint32_t numObjects = 0;
+		if( !ReadUint32( pCursor, m_pSnapshotEnd, numObjects ) )
+		{
+			return false;
+		}
+		for( uint32_t object = 0; object < numObjects; ++object )
+		{
+			uint64_t perTypeId = 0;
+			uint32_t numProperties = 0;
+			if( !ReadBytes( pCursor, m_pSnapshotEnd, &perTypeId, sizeof( perTypeId ) ) || !ReadUint32( pCursor, m_pSnapshotEnd, numProperties ) )
+			{
+				return false;
+			}
+			ObjectRecord record;
+			record.id.m_PerTypeId = (PerTypeObjectId)perTypeId;
+			record.id.m_ConstructorId = constructorId;
+			record.firstProperty = m_Properties.size();
+			record.numProperties = 0;
+
+			for( uint32_t prop = 0; prop < numProperties; ++prop )
+			{
+				uint32_t name = 0;
+				uint32_t type = 0;
+				uint32_t size = 0;
+				if( !ReadUint32( pCursor, m_pSnapshotEnd, name ) || !ReadUint32( pCursor, m_pSnapshotEnd, type )
+					|| !ReadUint32( pCursor, m_pSnapshotEnd, size ) || name >= numNames || (size_t)( m_pSnapshotEnd - pCursor ) < size )
+				{
+					return false;
+				}
+				const void* pValue = pCursor;
+				pCursor += size;
+				if( InvalidId == constructorId )
+				{
+					continue;
+				}
+
+				if( SERIALIZEDTYPE_OBJECTID == type && sizeof( ObjectId ) == size )
+				{
+					// ConstructorIds differ between processes
+					ObjectId* pId = (ObjectId*)Allocate( sizeof( ObjectId ), ARENA_DATA_ALIGNMENT );
+					memcpy( pId, pValue, sizeof( ObjectId ) );
+					if( pId->m_ConstructorId < constructorIds_.size() )
+					{
+						pId->m_ConstructorId = constructorIds_[ pId->m_ConstructorId ];
+					}
+					if( InvalidId == pId->m_ConstructorId )
+					{
+						pId->SetInvalid();
+					}
+					pValue = pId;
+				}
+				PropertyRecord property = { name, NULL, pValue, type, size };
+				m_Properties.push_back( property );
+				++record.numProperties;
+			}
+
+			if( InvalidId != constructorId )
+			{
+				if( m_Objects.size() && !( m_Objects.back().id < record.id ) )
+				{
+					m_bSorted = false;
+				}
+				m_Objects.push_back( record );
+				objectIds_.push_back( record.id );
+			}
+		}
+	}
+	return pCursor == m_pSnapshotEnd;
+}
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#ifndef ARENASERIALIZER_INCLUDED
+#define ARENASERIALIZER_INCLUDED
+
+#include "../ISimpleSerializer.h"
+
+#include <vector>
+#include <unordered_map>
+#include <stdio.h>
+#include <stdint.h>
+
+struct IObject;
+
+// ArenaSerializer - property store for object swapping with the same behaviour as SimpleSerializer,
+// but values and property names are placed in a bump arena, objects are indexed by a vector sorted
+// on ObjectId and property names are interned once per type. Clear() destroys all values and resets
+// the arena in one go, keeping the first block for reuse.
+// Properties are stored with their SerializedTypeId and size, and the property layout of each type is
+// hashed into a schema hash on save and load. On load a property whose type changed is converted if
+// both types are arithmetic, otherwise it is skipped rather than reinterpreted.
+class ArenaSerializer : public ISimpleSerializer
+{
+public:
+
+	ArenaSerializer();
+	virtual ~ArenaSerializer();
+
+	// ISimpleSerializer
+
+	void Clear();
+	void Clear(ObjectId ownerId);
+	void Clear(ObjectId ownerId, const char* propertyName);
+
+	void Serialize( IObject* pObject );
+
+	virtual bool IsLoading() const
+	{
+		return m_bLoading;
+	}
+	void SetIsLoading( bool loading );
+
+	virtual const IObject* GetCurrentObjectBeingSerialized() const
+	{
+		return m_pCurrentObject;
+	}
+
+	// ~ISimpleSerializer
+
+	// Properties of a type which changed type between save and load
+	struct SchemaChanges
+	{
+		bool						bSchemaChanged;	// schema hash of the first object loaded differs from the first saved
+		unsigned int				numConverted;
+		unsigned int				numSkipped;
+	};
+	SchemaChanges GetSchemaChanges( ConstructorId constructorId_ ) const;
+
+	// Snapshots hold the last serialized properties of each object in a file, with the type names
+	// indexed by ConstructorId. Only trivially copyable values are saved, pointers and other values are
+	// counted in numSkipped_. ObjectId properties are remapped to the ConstructorIds of the loading process.
+	// Call SetIsLoading( true ) before saving so the objects are in ObjectId order.
+	bool SaveSnapshot( FILE* pFile_, const std::vector<const char*>& typeNames_, size_t& numSkipped_ ) const;
+
+	// Loading a snapshot references pData_ rather than copying values, so it must remain valid until Clear().
+	// OpenSnapshot returns the type names of the snapshot, LoadSnapshot then reads the objects using
+	// ConstructorIds in this process for each type, InvalidId to ignore a type, and returns their ObjectIds
+	// in order. Returns false if the data is not a valid snapshot.
+	bool OpenSnapshot( const char* pData_, uint64_t size_, std::vector<const char*>& typeNames_ );
+	bool LoadSnapshot( const std::vector<ConstructorId>& constructorIds_, std::vector<ObjectId>& objectIds_ );
+
+private:
+	ArenaSerializer( const ArenaSerializer& );
+	ArenaSerializer& operator=( const ArenaSerializer& );
+
+	virtual void* AllocateValue( size_t size_, size_t alignment_ );
+	virtual void SetISerializedValue(const char* propertyName, const ISerializedValue* pValue);
+	virtual const ISerializedValue* GetISerializedValue(const char* propertyName) const;
+	virtual bool SupportsTypedProperties() const
+	{
+		return true;
+	}
+	virtual void SetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, const void* pData_, const ISerializedValue* pValue_ );
+	virtual bool GetTypedProperty( const char* propertyName, SerializedTypeId type_, size_t size_, void* pData_, const ISerializedValue** ppValue_ ) const;
+
+	void* Allocate( size_t size_, size_t alignment_ );
+
+	static const unsigned int InvalidName = (unsigned int)-1;
+
+	// interned property names of a type, indexed by ObjectId::m_ConstructorId
+	struct TypeNames
+	{
+		std::vector<const char*>						names;			// copies in the arena
+		std::unordered_map<const char*,unsigned int>	literalToName;	// cache of property name pointers, usually literals
+		unsigned int									saveSchemaHash;
+		unsigned int									loadSchemaHash;
+		bool											bSaveSchemaSet;
+		bool											bLoadSchemaSet;
+		unsigned int									numConverted;
+		unsigned int									numSkipped;
+		TypeNames() : saveSchemaHash( 0 ), loadSchemaHash( 0 ), bSaveSchemaSet( false ), bLoadSchemaSet( false ), numConverted( 0 ), numSkipped( 0 ) {}
+	};
+	unsigned int GetPropertyName( const char* propertyName, bool bAdd );
+	static unsigned int HashSchemaEntry( unsigned int hash_, const char* propertyName, SerializedTypeId type_, size_t size_ );
+
+	struct PropertyRecord
+	{
+		unsigned int				name;
+		const ISerializedValue*		pValue;	// NULL if cleared, or if the value is stored as bytes
+		const void*					pData;	// copy in the arena or snapshot data of a trivially copyable value
+		SerializedTypeId			type;	// SERIALIZEDTYPE_UNKNOWN for untyped values
+		size_t						size;
+	};
+	const PropertyRecord* FindProperty( const char* propertyName ) const;
+
+	// an object's properties are contiguous in m_Properties. Serializing an object again adds a
+	// new record, and the last record for an ObjectId is used when loading.
+	struct ObjectRecord
+	{
+		ObjectId					id;
+		size_t						firstProperty;
+		size_t						numProperties;
+	};
+	const ObjectRecord* FindObject( ObjectId id_ ) const;
+	void SortObjects();
+	const ObjectRecord& GetSortedObject( size_t index_ ) const
+	{
+		return m_Objects[ m_bSorted ? index_ : m_SortedObjects[ index_ ] ];
+	}
+
+	struct Block
+	{
+		char*						pData;
+		size_t						size;
+	};
+	std::vector<Block>				m_Blocks;
+	size_t							m_CurrentBlock;
+	size_t							m_CurrentBlockUsed;
+
+	std::vector<TypeNames>			m_TypeNames;
+	std::vector<PropertyRecord>		m_Properties;
+	std::vector<ObjectRecord>		m_Objects;
+	std::vector<size_t>				m_SortedObjects;	// indices into m_Objects, sorted by ObjectId then index
+	bool							m_bSorted;
+
+	bool							m_bLoading;
+	IObject*						m_pCurrentObject;
+	size_t							m_CurrentRecord;	// index into m_Objects when saving
+	const ObjectRecord*				m_pCurrentLoadRecord;
+	TypeNames*						m_pCurrentTypeNames;
+	mutable unsigned int			m_CurrentSchemaHash;	// of the object being serialized
+	bool							m_bHashCurrentSchema;	// true for the first object of a type
+
+	const char*						m_pSnapshotCursor;		// set by OpenSnapshot
+	const char*						m_pSnapshotEnd;
+	size_t							m_NumSnapshotTypes;
+};
+
+
+#endif // ARENASERIALIZER_INCLUDED
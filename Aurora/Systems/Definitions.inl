@@ -28,10 +28,11 @@
 // All typedefs, defines and macros start AU_ to avoid conflicts
 
 
-typedef int AUEntityId;           // (Will be a) salted id for uniquely identifying entities
+typedef int AUEntityId;           // Salted id for uniquely identifying entities, slot index and generation, 0 is invalid
 
 struct IRuntimeObjectSystem;
 struct IEntitySystem;
+struct IUpdateScheduler;
 struct ITimeSystem;
 struct ILogSystem;
 struct IAssetSystem;
@@ -24,11 +24,14 @@
 #include "../IUpdateable.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <new>
 
 //#include physics etc proxies for delete
 
 void EntitySystem::Entity::SetName(const char * sName) 
 {
+	m_pSystem->RemoveFromNameIndex(this);
 	if (sName && sName[0])
 	{
 #ifdef _WIN32
@@ -44,6 +47,7 @@ void EntitySystem::Entity::SetName(const char * sName)
 		m_sName[0] = '\0';
 		// And here
 	}
+	m_pSystem->AddToNameIndex(this);
 }
 
 void EntitySystem::Entity::SetObject(IEntityObject *pObject) { m_pObject = pObject; } // Not safe to delete, created in DLLs...
@@ -54,63 +58,234 @@ void EntitySystem::Entity::SetUpdateable(IAUUpdateable *pUpdateable) { m_pUpdate
 
 AUEntityId EntitySystem::Create(const char * sName)
 {
-	Entity *pEntity = new Entity(m_nextId++);
+	unsigned int slot = InvalidIndex;
+	if (m_NumFreeSlots > MinFreeSlots || (m_NumFreeSlots && m_Slots.size() == SlotIndexMask))
+	{
+		slot = m_FirstFreeSlot;
+		m_FirstFreeSlot = m_Slots[slot].nextFree;
+		if (m_FirstFreeSlot == InvalidIndex)
+		{
+			m_LastFreeSlot = InvalidIndex;
+		}
+		--m_NumFreeSlots;
+	}
+	else
+	{
+		slot = (unsigned int)m_Slots.size();
+		if (slot == SlotIndexMask)
+		{
+			assert(false); // out of slots
+			return 0;
+		}
+		if (slot % EntitiesPerChunk == 0)
+		{
+			m_EntityChunks.push_back(static_cast<Entity*>(::operator new(EntitiesPerChunk * sizeof(Entity))));
+		}
+		Slot newSlot = { 0, InvalidIndex, InvalidIndex };
+		m_Slots.push_back(newSlot);
+	}
+
+	AUEntityId id = (AUEntityId)((m_Slots[slot].generation << SlotIndexBits) | (slot + 1));
+	Entity *pEntity = new (GetSlotEntity(slot)) Entity(id, m_NextCreationSequence++, this);
+	m_Slots[slot].denseIndex = (unsigned int)m_Dense.size();
+	m_Dense.push_back(pEntity);
 	pEntity->SetName(sName);
-	m_Entities[pEntity->GetId()] = pEntity;
-	return pEntity->GetId();
+	return id;
 }
 
 bool EntitySystem::Destroy(AUEntityId id)
 {
-	TCESEntities::iterator it = m_Entities.find(id);
-	if (it != m_Entities.end())
+	Entity *pEntity = GetEntity(id);
+	if (pEntity)
 	{
-		IAUEntity *pEntity = it->second;
-		delete pEntity;
-		m_Entities.erase(it);
+		RemoveFromNameIndex(pEntity);
+		unsigned int slot = ((unsigned int)id & SlotIndexMask) - 1;
+		if (m_IterationDepth)
+		{
+			m_Dense[m_Slots[slot].denseIndex] = NULL;
+			++m_NumDenseRemoved;
+		}
+		else
+		{
+			CompactDense();
+			unsigned int denseIndex = m_Slots[slot].denseIndex;
+			Entity *pLast = m_Dense.back();
+			m_Dense[denseIndex] = pLast;
+			m_Slots[((unsigned int)pLast->m_id & SlotIndexMask) - 1].denseIndex = denseIndex;
+			m_Dense.pop_back();
+		}
+
+		pEntity->~Entity();
+		m_Slots[slot].generation = (m_Slots[slot].generation + 1) & GenerationMask;
+		m_Slots[slot].denseIndex = InvalidIndex;
+		m_Slots[slot].nextFree = InvalidIndex;
+		if (m_LastFreeSlot != InvalidIndex)
+		{
+			m_Slots[m_LastFreeSlot].nextFree = slot;
+		}
+		else
+		{
+			m_FirstFreeSlot = slot;
+		}
+		m_LastFreeSlot = slot;
+		++m_NumFreeSlots;
 		return true;
 	}
 
 	return false;
 }
 
-IAUEntity * EntitySystem::Get(AUEntityId id)
+EntitySystem::Entity * EntitySystem::GetEntity(AUEntityId id) const
 {
-	TCESEntities::iterator it = m_Entities.find(id);
-	if (it != m_Entities.end())
+	unsigned int slot = ((unsigned int)id & SlotIndexMask) - 1; // id 0 wraps to an invalid slot
+	if (id > 0 && slot < m_Slots.size()
+		&& m_Slots[slot].denseIndex != InvalidIndex
+		&& m_Slots[slot].generation == ((unsigned int)id >> SlotIndexBits))
 	{
-		return it->second;
+		return GetSlotEntity(slot);
 	}
-	
+
 	return NULL;
 }
 
+IAUEntity * EntitySystem::Get(AUEntityId id)
+{
+	return GetEntity(id);
+}
+
 IAUEntity * EntitySystem::Get(const char * sName)
 {
 	if (sName != NULL && *sName != '\0')
 	{
-		TCESEntities::iterator it = m_Entities.begin();
-		TCESEntities::iterator itEnd = m_Entities.end();
-		for (; it != itEnd; ++it)
+		TCESNameIndex::const_iterator it = m_NameIndex.find(sName);
+		if (it != m_NameIndex.end())
 		{
-			if (!strcmp(it->second->GetName(), sName))
-			{
-				return it->second;
-			}
+			return it->second.front();
 		}
 	}
 	
 	return NULL;
 }
 
+void EntitySystem::Get(const IAUDynArray<const char*> &names, IAUDynArray<IAUEntity*> &entities)
+{
+	entities.Resize(names.Size());
+	std::string name;
+	for (size_t i = 0; i < names.Size(); ++i)
+	{
+		entities[i] = NULL;
+		if (names[i] != NULL && *names[i] != '\0')
+		{
+			name = names[i]; // reuses the buffer
+			TCESNameIndex::const_iterator it = m_NameIndex.find(name);
+			if (it != m_NameIndex.end())
+			{
+				entities[i] = it->second.front();
+			}
+		}
+	}
+}
+
+bool EntitySystem::IsCreatedBefore(const Entity *pLhs, const Entity *pRhs)
+{
+	return pLhs->m_CreationSequence < pRhs->m_CreationSequence;
+}
+
+void EntitySystem::AddToNameIndex(Entity *pEntity)
+{
+	if (pEntity->m_sName[0] != '\0')
+	{
+		// newly created entities go at the end, renamed ones are inserted by creation order
+		std::vector<Entity*>& entities = m_NameIndex[pEntity->m_sName];
+		entities.insert(std::upper_bound(entities.begin(), entities.end(), pEntity, IsCreatedBefore), pEntity);
+	}
+}
+
+void EntitySystem::RemoveFromNameIndex(Entity *pEntity)
+{
+	if (pEntity->m_sName[0] != '\0')
+	{
+		TCESNameIndex::iterator it = m_NameIndex.find(pEntity->m_sName);
+		if (it != m_NameIndex.end())
+		{
+			std::vector<Entity*>& entities = it->second;
+			std::vector<Entity*>::iterator itEntity = std::lower_bound(entities.begin(), entities.end(), pEntity, IsCreatedBefore);
+			if (itEntity != entities.end() && *itEntity == pEntity)
+			{
+				entities.erase(itEntity);
+			}
+			if (entities.empty())
+			{
+				m_NameIndex.erase(it);
+			}
+		}
+	}
+}
+
 void EntitySystem::GetAll(IAUDynArray<AUEntityId> &entities) const
 {
-	entities.Resize(m_Entities.size());
-	TCESEntities::const_iterator it = m_Entities.begin();
-	TCESEntities::const_iterator itEnd = m_Entities.end();
-	for(int i = 0; it != itEnd; ++it, ++i)
+	entities.Resize(m_Dense.size() - m_NumDenseRemoved);
+	size_t numEntities = 0;
+	for (size_t i = 0; i < m_Dense.size(); ++i)
 	{
-		entities[i] = it->second->m_id;
+		if (m_Dense[i])
+		{
+			entities[numEntities++] = m_Dense[i]->m_id;
+		}
+	}
+}
+
+void EntitySystem::ForEach(IAUEntityVisitor &visitor, unsigned int filter)
+{
+	if (!m_IterationDepth)
+	{
+		CompactDense();
+	}
+	++m_IterationDepth;
+
+	bool bUpdateable = (filter & AU_ENTITY_FILTER_UPDATEABLE) != 0;
+	bool bRenderable = (filter & AU_ENTITY_FILTER_RENDERABLE) != 0;
+	size_t numEntities = m_Dense.size(); // entities created by visitors are not visited
+	for (size_t i = 0; i < numEntities; ++i)
+	{
+		Entity *pEntity = m_Dense[i];
+		if (pEntity
+			&& (!bUpdateable || pEntity->m_pUpdateable)
+			&& (!bRenderable || pEntity->m_pRenderable))
+		{
+			visitor.Visit(pEntity);
+		}
+	}
+
+	--m_IterationDepth;
+	if (!m_IterationDepth)
+	{
+		CompactDense();
+	}
+}
+
+void EntitySystem::AbortIterations()
+{
+	m_IterationDepth = 0;
+	CompactDense();
+}
+
+void EntitySystem::CompactDense()
+{
+	if (m_NumDenseRemoved)
+	{
+		size_t numEntities = 0;
+		for (size_t i = 0; i < m_Dense.size(); ++i)
+		{
+			Entity *pEntity = m_Dense[i];
+			if (pEntity)
+			{
+				m_Slots[((unsigned int)pEntity->m_id & SlotIndexMask) - 1].denseIndex = (unsigned int)numEntities;
+				m_Dense[numEntities++] = pEntity;
+			}
+		}
+		m_Dense.resize(numEntities);
+		m_NumDenseRemoved = 0;
 	}
 }
 
@@ -123,16 +298,28 @@ void EntitySystem::Reset()
 		Destroy(entities[i]);
 	}
 
-	assert(m_Entities.size() == 0);
+	assert(m_Dense.size() == m_NumDenseRemoved);
+	assert(m_NameIndex.empty());
 }
 
 
-EntitySystem::EntitySystem(void) : m_nextId(1)
+EntitySystem::EntitySystem(void)
+	: m_FirstFreeSlot(InvalidIndex)
+	, m_LastFreeSlot(InvalidIndex)
+	, m_NumFreeSlots(0)
+	, m_IterationDepth(0)
+	, m_NumDenseRemoved(0)
+	, m_NextCreationSequence(0)
 {
 }
 
 EntitySystem::~EntitySystem(void)
 {
+	Reset();
+	for (size_t i = 0; i < m_EntityChunks.size(); ++i)
+	{
+		::operator delete(m_EntityChunks[i]);
+	}
 }
 
 
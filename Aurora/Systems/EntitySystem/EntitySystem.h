@@ -19,7 +19,10 @@
 
 #include "../IEntitySystem.h"
 
-#include <map>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class EntitySystem : public IEntitySystem
 {
@@ -29,7 +32,10 @@ public:
 	bool Destroy(AUEntityId id);
 	IAUEntity * Get(AUEntityId id);
 	IAUEntity * Get(const char * sName);
+	void Get(const IAUDynArray<const char*> &names, IAUDynArray<IAUEntity*> &entities);
 	void GetAll(IAUDynArray<AUEntityId> &entities) const;
+	void ForEach(IAUEntityVisitor &visitor, unsigned int filter);
+	void AbortIterations();
 	void Reset();
 
 	/// New methods
@@ -41,6 +47,8 @@ protected:
 	{
 	public:
 		AUEntityId m_id;
+		uint64_t m_CreationSequence;	// orders entities by creation, as ids reuse slots
+		EntitySystem* m_pSystem;
 		IEntityObject* m_pObject;
 		IAURenderable* m_pRenderable;
 		//IAUTransform * m_pTransform
@@ -90,16 +98,66 @@ protected:
 
 		/// New methods
 
-		Entity(AUEntityId id)
+		Entity(AUEntityId id, uint64_t creationSequence, EntitySystem* pSystem)
 			: m_id(id)
+			, m_CreationSequence(creationSequence)
+			, m_pSystem(pSystem)
 			, m_pRenderable(0)
 			, m_pUpdateable(0)
 			, m_vScale(1.0f, 1.0f, 1.0f)
 			, m_pObject( NULL )
- 			{ m_sName[0] = '\n'; }
+ 			{ m_sName[0] = '\0'; }
 	};
 
-	typedef std::map<AUEntityId, Entity*> TCESEntities;
-	TCESEntities m_Entities;
-	AUEntityId m_nextId;
+	// Generational slot map. An AUEntityId holds a slot index plus one in its low bits, so 0 is never
+	// valid, and the slot's generation in the high bits, which is incremented when the slot is freed so
+	// stale ids are detected until it wraps. Entities are stored in chunks indexed by slot and never move
+	// as IAUEntity pointers are held elsewhere, while m_Dense lists the live entities contiguously for
+	// iteration and is swap-removed on destroy.
+	static const unsigned int SlotIndexBits = 20;
+	static const unsigned int SlotIndexMask = ( 1u << SlotIndexBits ) - 1;
+	static const unsigned int GenerationMask = ( 1u << ( 31 - SlotIndexBits ) ) - 1;	// ids stay positive
+
+	// A stale id only aliases a live entity once its slot has been reused GenerationMask + 1 (2048) times.
+	// Freed slots are queued and reused oldest first, and only while more than MinFreeSlots are queued,
+	// so that takes over 2048 * MinFreeSlots destroys rather than 2048 when one entity is respawned.
+	static const unsigned int MinFreeSlots = 1024;
+	static const unsigned int EntitiesPerChunk = 256;
+	static const unsigned int InvalidIndex = (unsigned int)-1;
+
+	struct Slot
+	{
+		unsigned int generation;
+		unsigned int denseIndex;	// index into m_Dense, InvalidIndex if free
+		unsigned int nextFree;		// next free slot if free, InvalidIndex for the last
+	};
+	std::vector<Slot> m_Slots;
+	std::vector<Entity*> m_EntityChunks;
+	std::vector<Entity*> m_Dense;
+	unsigned int m_FirstFreeSlot;	// reused next
+	unsigned int m_LastFreeSlot;	// most recently freed
+	unsigned int m_NumFreeSlots;
+
+	// During ForEach destroyed entities leave a NULL in m_Dense, so indices do not change under the
+	// iteration, and m_Dense is compacted when the outermost ForEach ends. m_IterationDepth counts the
+	// active ForEach calls, and is reset by AbortIterations when a visitor crashed and was recovered by
+	// a RuntimeProtector, as that ForEach never returns.
+	unsigned int m_IterationDepth;
+	size_t m_NumDenseRemoved;
+	void CompactDense();
+
+	Entity* GetEntity(AUEntityId id) const;	// NULL if id is not a live entity
+	Entity* GetSlotEntity(unsigned int slot) const
+	{
+		return m_EntityChunks[slot / EntitiesPerChunk] + slot % EntitiesPerChunk;
+	}
+
+	// Entities with each non-empty name, in creation order so the first is the one Get returns.
+	// Kept up to date by Create, Destroy and Entity::SetName.
+	typedef std::unordered_map<std::string, std::vector<Entity*> > TCESNameIndex;
+	TCESNameIndex m_NameIndex;
+	uint64_t m_NextCreationSequence;
+	void AddToNameIndex(Entity *pEntity);
+	void RemoveFromNameIndex(Entity *pEntity);
+	static bool IsCreatedBefore(const Entity *pLhs, const Entity *pRhs);
 };
\ No newline at end of file
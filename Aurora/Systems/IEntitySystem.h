@@ -34,6 +34,20 @@
 #include <vector>
 
 
+// Filters for IEntitySystem::ForEach, combined entities must have all of them
+enum AUEntityFilter
+{
+	AU_ENTITY_FILTER_NONE			= 0,
+	AU_ENTITY_FILTER_UPDATEABLE		= 1 << 0,	// has an IAUUpdateable
+	AU_ENTITY_FILTER_RENDERABLE		= 1 << 1,	// has an IAURenderable
+};
+
+struct IAUEntityVisitor
+{
+	virtual void Visit(IAUEntity *pEntity) = 0;
+	virtual ~IAUEntityVisitor() {}
+};
+
 struct IEntitySystem : public ISystem
 {
 	/// ISystem interface
@@ -49,7 +63,16 @@ struct IEntitySystem : public ISystem
 	virtual bool Destroy(AUEntityId nId) = 0;              // Cleanup and destroy an existing entity. Returns false iff no such id.
 	virtual IAUEntity * Get(AUEntityId id) = 0;
 	virtual IAUEntity * Get(const char * sName) = 0;  // Get first entity that matches this name (not sure if we want to enforce name uniqueness?)
+	virtual void Get(const IAUDynArray<const char*> &names, IAUDynArray<IAUEntity*> &entities) = 0;  // Get for each name, NULL where none match
 	virtual void GetAll(IAUDynArray<AUEntityId> &entities) const = 0;
+
+	// Visits each entity matching filter directly from storage, without copying ids. Entities destroyed during
+	// the iteration are not visited after that, and entities created during it are not visited.
+	virtual void ForEach(IAUEntityVisitor &visitor, unsigned int filter = AU_ENTITY_FILTER_NONE) = 0;
+
+	// Call when a RuntimeProtector has recovered from a crash which may have been in a ForEach visitor, from
+	// outside any ForEach. The interrupted ForEach calls never return, so this ends them.
+	virtual void AbortIterations() = 0;
 };
 
 #endif // IENTITYSYSTEM_INCLUDED
\ No newline at end of file
@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#ifndef IUPDATESCHEDULER_INCLUDED
+#define IUPDATESCHEDULER_INCLUDED
+
+#include "ISystem.h"
+
+struct IEntitySystem;
+struct IRuntimeObjectSystem;
+
+// Updates the IAUUpdateable of each entity. Updateables which return true from IsThreadSafe are split
+// into chunks which are updated on a fixed pool of worker threads and the calling thread, the others
+// are then updated serially on the calling thread in entity order.
+// Each thread runs its chunks in its own RuntimeProtector, so a crash in an update is caught as with
+// a single protected update loop: updates which crashed are not run again until a new module is loaded.
+struct IUpdateScheduler : public ISystem
+{
+	virtual ~IUpdateScheduler() {};
+
+	virtual void SetNumThreads(unsigned int numThreads) = 0;      // Worker threads in addition to the calling thread, 0 for serial updates only
+	virtual unsigned int GetNumThreads() const = 0;
+	virtual void SetChunkSize(unsigned int numUpdateables) = 0;   // Thread safe updateables per unit of work
+
+	// Returns false if an exception was caught in an update, details are in the log
+	virtual bool Update(IEntitySystem *pEntitySystem, IRuntimeObjectSystem *pRuntimeObjectSystem, float deltaTime) = 0;
+};
+
+#endif // IUPDATESCHEDULER_INCLUDED
\ No newline at end of file
@@ -23,6 +23,11 @@
 struct IAUUpdateable
 {
 	virtual void Update( float deltaTime ) = 0;
+
+	// Return true to allow the IUpdateScheduler to call Update on a worker thread, in parallel with
+	// other thread safe updateables. Such an Update must only change its own object and entity, and
+	// must not create or destroy entities or objects.
+	virtual bool IsThreadSafe() const { return false; }
 };
 
 #endif // IAUUPDATEABLE_INCLUDED
\ No newline at end of file
@@ -0,0 +1,401 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "AsyncLogSystem.h"
+
+// The file is created on the first real output, and only closed on shutdown or when the path changes
+
+#include <stdarg.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+
+#pragma warning( disable : 4996 4800 )
+
+static const unsigned int WRITER_WAIT_MS = 10;	// Longest time a message waits when the ring is not getting full
+
+
+AsyncLogSystem::AsyncLogSystem( unsigned int ringSizeKB )
+	: m_eVerbosity( eLV_EVENTS )
+	, m_eOverflowPolicy( eOP_BLOCK )
+	, m_EnqueuePos( 0 )
+	, m_DequeuePos( 0 )
+	, m_NumDropped( 0 )
+	, m_NumBlocked( 0 )
+#ifdef _WIN32
+	, m_fp( NULL )
+#else
+	, m_fd( -1 )
+#endif
+	, m_WrittenPos( 0 )
+	, m_bWakeRequested( false )
+	, m_bReopen( false )
+	, m_bStop( false )
+{
+	// power of two number of slots, with room for a few maximum length messages
+	size_t numSlots = 1;
+	while( numSlots < 2 * MaxSlotsPerMessage || numSlots * sizeof( Slot ) < (size_t)ringSizeKB * 1024 )
+	{
+		numSlots *= 2;
+	}
+	m_pSlots = new Slot[ numSlots ];
+	m_SlotMask = numSlots - 1;
+	for( size_t i = 0; i < numSlots; ++i )
+	{
+		m_pSlots[i].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	m_Thread = std::thread( &AsyncLogSystem::WriterThread, this );
+}
+
+AsyncLogSystem::~AsyncLogSystem(void)
+{
+	Flush();
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_bStop = true;
+		m_bWakeRequested = true;
+	}
+	m_WakeCondition.notify_one();
+	m_Thread.join();
+
+	CloseFile();
+	delete[] m_pSlots;
+}
+
+bool AsyncLogSystem::SetLogPath( const char * sPath, bool bTest )
+{
+	Flush();
+
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	m_sPath = sPath;
+	m_bReopen = true;
+
+	if (!bTest) return true;
+	FILE *fp = fopen(m_sPath.c_str(),"wt");
+	if (!fp) return false;
+	if (fclose(fp)) return false;
+
+	return true;
+}
+
+void AsyncLogSystem::SetOverflowPolicy( EOverflowPolicy ePolicy )
+{
+	m_eOverflowPolicy = ePolicy;
+}
+
+void AsyncLogSystem::Flush()
+{
+	// messages claimed by other threads but not yet published are waited for as well
+	const size_t flushPos = m_EnqueuePos.load( std::memory_order_acquire );
+
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	m_bWakeRequested = true;
+	m_WakeCondition.notify_one();
+	while( (intptr_t)( m_WrittenPos - flushPos ) < 0 )
+	{
+		m_WrittenCondition.wait( lock );
+	}
+}
+
+unsigned int AsyncLogSystem::GetNumDropped() const
+{
+	return m_NumDropped.load( std::memory_order_relaxed );
+}
+
+unsigned int AsyncLogSystem::GetNumBlocked() const
+{
+	return m_NumBlocked.load( std::memory_order_relaxed );
+}
+
+ELogVerbosity AsyncLogSystem::GetVerbosity() const
+{
+	return m_eVerbosity;
+}
+
+void AsyncLogSystem::SetVerbosity(ELogVerbosity eVerbosity)
+{
+	m_eVerbosity = eVerbosity;
+}
+
+AsyncLogSystem::TVerbosityPeeker AsyncLogSystem::GetVerbosityPeeker() const
+{
+	return (&m_eVerbosity);
+}
+
+void AsyncLogSystem::Log(ELogVerbosity eVerbosity, const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	LogInternal(eVerbosity, format, args);
+	va_end(args);
+}
+
+void AsyncLogSystem::LogVa(va_list args, ELogVerbosity eVerbosity, const char * format)
+{
+	LogInternal(eVerbosity, format, args);
+}
+
+void AsyncLogSystem::LogInternal(ELogVerbosity eVerbosity, const char * format, va_list args)
+{
+	if (eVerbosity > m_eVerbosity || eVerbosity == eLV_NEVER) return;
+
+	// Format on the stack so any number of threads can log at once
+	char buff[LOGSYSTEM_MAX_BUFFER];
+	int result = vsnprintf(buff, LOGSYSTEM_MAX_BUFFER, format, args);
+	if (result <= 0) return;
+	// Make sure there's a limit to the amount of rubbish we can output
+	unsigned int length = result < LOGSYSTEM_MAX_BUFFER ? (unsigned int)result : LOGSYSTEM_MAX_BUFFER - 1;
+
+	Enqueue(buff, length);
+}
+
+bool AsyncLogSystem::Enqueue( const char * pText, unsigned int length )
+{
+	const size_t numSlots = ( length + SlotTextSize - 1 ) / SlotTextSize;
+	const size_t ringSize = m_SlotMask + 1;
+	bool bBlocked = false;
+
+	// Claim numSlots consecutive positions. The writer frees slots in order, so when the
+	// last slot needed is free for this lap so are the others.
+	size_t pos = m_EnqueuePos.load( std::memory_order_relaxed );
+	while( true )
+	{
+		const size_t lastPos = pos + numSlots - 1;
+		const size_t sequence = m_pSlots[ lastPos & m_SlotMask ].sequence.load( std::memory_order_acquire );
+		const intptr_t diff = (intptr_t)( sequence - lastPos );
+		if( diff == 0 )
+		{
+			if( m_EnqueuePos.compare_exchange_weak( pos, pos + numSlots, std::memory_order_relaxed ) )
+			{
+				break;
+			}
+		}
+		else if( diff < 0 )
+		{
+			// Ring is full
+			if( m_eOverflowPolicy == eOP_DROP )
+			{
+				m_NumDropped.fetch_add( 1, std::memory_order_relaxed );
+				return false;
+			}
+			if( !bBlocked )
+			{
+				bBlocked = true;
+				m_NumBlocked.fetch_add( 1, std::memory_order_relaxed );
+			}
+			m_WakeCondition.notify_one();
+			std::this_thread::yield();
+			pos = m_EnqueuePos.load( std::memory_order_relaxed );
+		}
+		else
+		{
+			// Another thread claimed pos first
+			pos = m_EnqueuePos.load( std::memory_order_relaxed );
+		}
+	}
+
+	for( size_t i = 0; i < numSlots; ++i )
+	{
+		const unsigned int offset = (unsigned int)i * SlotTextSize;
+		const unsigned int sliceLength = length - offset < SlotTextSize ? length - offset : SlotTextSize;
+		memcpy( m_pSlots[ ( pos + i ) & m_SlotMask ].text, pText + offset, sliceLength );
+	}
+	Slot& first = m_pSlots[ pos & m_SlotMask ];
+	first.length = length;
+	first.sequence.store( pos + 1, std::memory_order_release );
+
+	// Only wake the writer early when the ring is getting full, otherwise it picks messages up in batches
+	if( pos + numSlots - m_DequeuePos.load( std::memory_order_relaxed ) > ringSize / 2 )
+	{
+		m_WakeCondition.notify_one();
+	}
+	return true;
+}
+
+void AsyncLogSystem::WriterThread()
+{
+	const size_t ringSize = m_SlotMask + 1;
+	size_t pos = 0;
+
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	while( true )
+	{
+		// Writing happens under m_Mutex, which only Flush and SetLogPath wait on
+		if( m_bReopen )
+		{
+			CloseFile();
+			m_bReopen = false;
+		}
+
+		// Take all messages published in order from pos
+		size_t endPos = pos;
+		while( endPos - pos + MaxSlotsPerMessage <= ringSize )
+		{
+			const Slot& slot = m_pSlots[ endPos & m_SlotMask ];
+			if( slot.sequence.load( std::memory_order_acquire ) != endPos + 1 )
+			{
+				break;
+			}
+			endPos += ( slot.length + SlotTextSize - 1 ) / SlotTextSize;
+		}
+
+		if( endPos != pos )
+		{
+			WriteBatch( pos, endPos );
+			for( size_t i = pos; i < endPos; ++i )
+			{
+				m_pSlots[ i & m_SlotMask ].sequence.store( i + ringSize, std::memory_order_release );
+			}
+			pos = endPos;
+			m_DequeuePos.store( pos, std::memory_order_relaxed );
+			m_WrittenPos = pos;
+			m_WrittenCondition.notify_all();
+			continue;
+		}
+
+		if( m_bStop && m_EnqueuePos.load( std::memory_order_acquire ) == pos )
+		{
+			return;
+		}
+		if( !m_bWakeRequested )
+		{
+			m_WakeCondition.wait_for( lock, std::chrono::milliseconds( WRITER_WAIT_MS ) );
+		}
+		m_bWakeRequested = false;
+	}
+}
+
+#ifdef _WIN32
+
+bool AsyncLogSystem::OpenFile()
+{
+	m_fp = fopen(m_sPath.c_str(),"wt");
+	return m_fp;
+}
+
+bool AsyncLogSystem::CloseFile()
+{
+	if (!m_fp) return false;
+	bool bResult = fclose(m_fp);
+	m_fp = NULL;
+	return bResult;
+}
+
+bool AsyncLogSystem::WriteBatch( size_t startPos, size_t endPos )
+{
+	if (!m_fp) OpenFile();
+	if (!m_fp) return false;
+
+	bool bResult = true;
+	size_t pos = startPos;
+	while( pos != endPos )
+	{
+		const Slot& first = m_pSlots[ pos & m_SlotMask ];
+		unsigned int remaining = first.length;
+		while( remaining )
+		{
+			const unsigned int sliceLength = remaining < SlotTextSize ? remaining : SlotTextSize;
+			bResult &= fwrite( m_pSlots[ pos & m_SlotMask ].text, 1, sliceLength, m_fp ) == sliceLength;
+			remaining -= sliceLength;
+			++pos;
+		}
+	}
+	bResult &= !fflush(m_fp);
+	return bResult;
+}
+
+#else
+
+bool AsyncLogSystem::OpenFile()
+{
+	m_fd = open(m_sPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	return m_fd != -1;
+}
+
+bool AsyncLogSystem::CloseFile()
+{
+	if (m_fd == -1) return false;
+	bool bResult = close(m_fd);
+	m_fd = -1;
+	return bResult;
+}
+
+bool AsyncLogSystem::WriteBatch( size_t startPos, size_t endPos )
+{
+	if (m_fd == -1) OpenFile();
+	if (m_fd == -1) return false;
+
+	// one iovec per slot, written IOV_MAX at a time
+	const int MaxIovecs = 64 < IOV_MAX ? 64 : IOV_MAX;
+	struct iovec iovecs[ 64 ];
+	size_t pos = startPos;
+	unsigned int remaining = 0;
+	while( pos != endPos || remaining )
+	{
+		int numIovecs = 0;
+		while( numIovecs < MaxIovecs && ( pos != endPos || remaining ) )
+		{
+			Slot& slot = m_pSlots[ pos & m_SlotMask ];
+			if( !remaining )
+			{
+				remaining = slot.length;
+			}
+			const unsigned int sliceLength = remaining < SlotTextSize ? remaining : SlotTextSize;
+			iovecs[ numIovecs ].iov_base = slot.text;
+			iovecs[ numIovecs ].iov_len = sliceLength;
+			++numIovecs;
+			remaining -= sliceLength;
+			++pos;
+		}
+
+		// writev may write only part of the data
+		struct iovec* pIovecs = iovecs;
+		while( numIovecs )
+		{
+			ssize_t written = writev( m_fd, pIovecs, numIovecs );
+			if( written < 0 )
+			{
+				if( errno == EINTR ) continue;
+				return false;
+			}
+			while( numIovecs && (size_t)written >= pIovecs->iov_len )
+			{
+				written -= pIovecs->iov_len;
+				++pIovecs;
+				--numIovecs;
+			}
+			if( numIovecs )
+			{
+				pIovecs->iov_base = (char*)pIovecs->iov_base + written;
+				pIovecs->iov_len -= written;
+			}
+		}
+	}
+	return true;
+}
+
+#endif
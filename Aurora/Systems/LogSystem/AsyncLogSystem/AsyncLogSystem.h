@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#ifndef ASYNCLOGSYSTEM_INCLUDED
+#define ASYNCLOGSYSTEM_INCLUDED
+
+#include "../../ILogSystem.h"
+
+#include <string>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// This implementation logs to a file from a background thread
+// Log formats the message into a lock free ring which any number of threads may write to at once,
+// and the writer thread outputs all waiting messages with a single write when woken or every few ms.
+// Output is not flushed per line: call Flush before anything which may end the process, such as
+// on shutdown or when handling a crash, to be sure everything logged so far is in the file.
+
+class AsyncLogSystem : public ILogSystem
+{
+public:
+	// What Log does when the ring is full
+	enum EOverflowPolicy
+	{
+		eOP_DROP,		// Discard the message, counted by GetNumDropped
+		eOP_BLOCK,		// Wait for the writer thread to make space, counted by GetNumBlocked
+	};
+
+	//// Unique to this implementation
+
+	bool SetLogPath( const char * sPath, bool bTest = false );  // Set path of file to use for logging. bTest = true will cause it to try to create and close the file.
+	                                                            // Returns false iff a test was attempted and failed.
+	void SetOverflowPolicy( EOverflowPolicy ePolicy );
+	void Flush();                                               // Blocks until all messages logged before the call are written
+	unsigned int GetNumDropped() const;
+	unsigned int GetNumBlocked() const;
+
+	AsyncLogSystem( unsigned int ringSizeKB = 256 );            // Ring memory, messages use it in blocks of about 256 bytes
+	~AsyncLogSystem(void);                                      // Flushes and stops the writer thread
+
+	ELogVerbosity GetVerbosity() const;
+	void SetVerbosity(ELogVerbosity eVerbosity); 
+	TVerbosityPeeker GetVerbosityPeeker() const;
+
+	void Log(ELogVerbosity eVerbosity, const char * format, ...);
+	void LogVa(va_list args, ELogVerbosity eVerbosity, const char * format);
+
+
+protected:
+	// A message occupies one or more consecutive slots, the first holding its length. Slot sequence
+	// numbers say which lap of the ring a slot is free for (sequence == position) or holds a published
+	// message for (sequence == position + 1), only the first slot of a message is published.
+	static const unsigned int SlotTextSize = 240;
+	static const unsigned int MaxSlotsPerMessage = ( LOGSYSTEM_MAX_BUFFER + SlotTextSize - 1 ) / SlotTextSize;
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		unsigned int length;
+		char text[SlotTextSize];
+	};
+
+	void LogInternal(ELogVerbosity eVerbosity, const char * format, va_list args);
+	bool Enqueue( const char * pText, unsigned int length );
+	void WriterThread();
+	bool OpenFile();
+	bool CloseFile();
+	bool WriteBatch( size_t startPos, size_t endPos );
+
+	std::string m_sPath;
+	ELogVerbosity m_eVerbosity;
+	EOverflowPolicy m_eOverflowPolicy;
+
+	Slot* m_pSlots;
+	size_t m_SlotMask;
+	std::atomic<size_t> m_EnqueuePos;
+	std::atomic<size_t> m_DequeuePos;
+	std::atomic<unsigned int> m_NumDropped;
+	std::atomic<unsigned int> m_NumBlocked;
+
+	// Only used by the writer thread, apart from SetLogPath
+#ifdef _WIN32
+	FILE *m_fp;
+#else
+	int m_fd;
+#endif
+
+	// The writer thread waits on m_WakeCondition, Flush waits on m_WrittenCondition for m_WrittenPos
+	std::thread m_Thread;
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeCondition;
+	std::condition_variable m_WrittenCondition;
+	size_t m_WrittenPos;
+	bool m_bWakeRequested;
+	bool m_bReopen;
+	bool m_bStop;
+};
+
+
+#endif //ASYNCLOGSYSTEM_INCLUDED
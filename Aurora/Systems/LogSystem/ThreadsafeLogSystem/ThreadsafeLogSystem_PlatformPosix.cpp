@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef _WIN32
+
+#include "ThreadsafeLogSystem.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <assert.h>
+#include <vector>
+
+/*
+	Posix implementation, which does not serialize logging threads on the wrapped log system.
+	Messages are formatted by the logging thread with no lock held, then appended to a queue under
+	queueMutex, held only for the copy. Whichever thread then gets forwardMutex forwards everything
+	queued to the wrapped log system in order, while threads which find it taken just return, as the
+	forwarding thread will pick up their messages. So the wrapped log system is only called by one
+	thread at a time, and is called on the logging threads as on Windows.
+*/
+
+struct ThreadsafeLogSystem::TLSPlatformImpl
+{
+	struct Message
+	{
+		ELogVerbosity eVerbosity;
+		size_t offset;				// Into text, null terminated
+	};
+
+	pthread_mutex_t queueMutex;
+	std::vector<Message> queue;
+	std::vector<char> queueText;
+
+	pthread_mutex_t forwardMutex;	// Held while calling the wrapped log system
+	std::vector<Message> forwarding;
+	std::vector<char> forwardingText;
+};
+
+
+ThreadsafeLogSystem::ThreadsafeLogSystem(void)
+{
+	m_pImpl = new TLSPlatformImpl();
+	pthread_mutex_init(&(m_pImpl->queueMutex), NULL);
+	pthread_mutex_init(&(m_pImpl->forwardMutex), NULL);
+
+	m_eVerbosity = eLV_COMMENTS;   // By default, defer any filtering
+	m_protectedLogger = NULL;			
+}
+
+ThreadsafeLogSystem::~ThreadsafeLogSystem(void)
+{
+	delete m_protectedLogger;
+	pthread_mutex_destroy(&(m_pImpl->forwardMutex));
+	pthread_mutex_destroy(&(m_pImpl->queueMutex));
+	delete m_pImpl;
+}
+
+void ThreadsafeLogSystem::SetProtectedLogSystem(ILogSystem *pLogSystem)
+{
+	pthread_mutex_lock(&(m_pImpl->forwardMutex));
+
+	if (m_protectedLogger)
+		delete m_protectedLogger;
+	m_protectedLogger = pLogSystem;
+
+	pthread_mutex_unlock(&(m_pImpl->forwardMutex));
+}
+
+ELogVerbosity ThreadsafeLogSystem::GetVerbosity() const
+{
+	return m_eVerbosity;
+}
+
+void ThreadsafeLogSystem::SetVerbosity(ELogVerbosity eVerbosity)
+{
+	// Aligned enum store, seen by other threads peeking as either the old or new value
+	m_eVerbosity = eVerbosity;
+}
+
+ThreadsafeLogSystem::TVerbosityPeeker ThreadsafeLogSystem::GetVerbosityPeeker() const
+{
+	return (&m_eVerbosity);
+}
+
+void ThreadsafeLogSystem::Log(ELogVerbosity eVerbosity, const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	LogInternal(eVerbosity, format, args);
+	va_end(args);
+}
+
+void ThreadsafeLogSystem::LogVa(va_list args, ELogVerbosity eVerbosity, const char * format)
+{
+	LogInternal(eVerbosity, format, args);
+}
+
+void ThreadsafeLogSystem::LogInternal(ELogVerbosity eVerbosity, const char * format, va_list args)
+{
+	if (eVerbosity > m_eVerbosity || eVerbosity == eLV_NEVER) return;
+
+	// Format on this thread's stack, with no lock held
+	char buff[LOGSYSTEM_MAX_BUFFER];
+	int result = vsnprintf(buff, LOGSYSTEM_MAX_BUFFER, format, args);
+	if (result < 0) return;
+	// Make sure there's a limit to the amount of rubbish we can output
+	size_t length = result < LOGSYSTEM_MAX_BUFFER ? (size_t)result : LOGSYSTEM_MAX_BUFFER - 1;
+
+	TLSPlatformImpl::Message message;
+	message.eVerbosity = eVerbosity;
+
+	pthread_mutex_lock(&(m_pImpl->queueMutex));
+	message.offset = m_pImpl->queueText.size();
+	m_pImpl->queueText.insert(m_pImpl->queueText.end(), buff, buff + length);
+	m_pImpl->queueText.push_back('\0');
+	m_pImpl->queue.push_back(message);
+	pthread_mutex_unlock(&(m_pImpl->queueMutex));
+
+	// If another thread is forwarding it will forward this message too, as it checks the
+	// queue again after releasing forwardMutex
+	while (pthread_mutex_trylock(&(m_pImpl->forwardMutex)) == 0)
+	{
+		while (true)
+		{
+			// Swap so the queue keeps the capacity of the previous batch
+			pthread_mutex_lock(&(m_pImpl->queueMutex));
+			m_pImpl->forwarding.swap(m_pImpl->queue);
+			m_pImpl->forwardingText.swap(m_pImpl->queueText);
+			pthread_mutex_unlock(&(m_pImpl->queueMutex));
+
+			if (m_pImpl->forwarding.empty()) break;
+
+			for (size_t i = 0; i < m_pImpl->forwarding.size(); ++i)
+			{
+				const TLSPlatformImpl::Message& forward = m_pImpl->forwarding[i];
+				if (m_protectedLogger)
+				{
+					m_protectedLogger->Log(forward.eVerbosity, "%s", &(m_pImpl->forwardingText[forward.offset]));
+				}
+			}
+			m_pImpl->forwarding.clear();
+			m_pImpl->forwardingText.clear();
+		}
+		pthread_mutex_unlock(&(m_pImpl->forwardMutex));
+
+		pthread_mutex_lock(&(m_pImpl->queueMutex));
+		bool bQueueEmpty = m_pImpl->queue.empty();
+		pthread_mutex_unlock(&(m_pImpl->queueMutex));
+		if (bQueueEmpty) break;
+	}
+}
+
+#endif // #ifndef _WIN32
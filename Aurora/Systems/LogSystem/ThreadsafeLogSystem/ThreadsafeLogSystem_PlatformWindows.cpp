@@ -15,39 +15,12 @@
 //    misrepresented as being the original software.
 // 3. This notice may not be removed or altered from any source distribution.
 
-#include "ThreadsafeLogSystem.h"
-
 #ifdef _WIN32
-    #include <Windows.h>
-    #include <concrt.h>
-#else
-#include <pthread.h>
-
-// Linux / Mac OS X implementation of critical sections
-// Not as efficient as a spin lock might be for this purpose, should probably move to one of those at some point
-typedef pthread_mutex_t CRITICAL_SECTION;
-
-void InitializeCriticalSection( CRITICAL_SECTION* pCrit )
-{
-    pthread_mutex_init(pCrit, NULL);
-}
-
-void DeleteCriticalSection( CRITICAL_SECTION* pCrit )
-{
-   //do nothing
-}
-
-void EnterCriticalSection( CRITICAL_SECTION* pCrit )
-{
-    pthread_mutex_lock( pCrit );
-}
 
-void LeaveCriticalSection( CRITICAL_SECTION* pCrit )
-{
-    pthread_mutex_unlock( pCrit );
-}
+#include "ThreadsafeLogSystem.h"
 
-#endif
+#include <Windows.h>
+#include <concrt.h>
 
 #include <stdarg.h>
 #include <assert.h>
@@ -130,3 +103,5 @@ void ThreadsafeLogSystem::LogInternal(ELogVerbosity eVerbosity, const char * for
 
 	LeaveCriticalSection(&(m_pImpl->critSec));
 }
+
+#endif // #ifdef _WIN32
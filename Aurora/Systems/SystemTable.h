@@ -31,6 +31,7 @@ struct SystemTable
 	ITimeSystem *pTimeSystem;
 	ILogSystem *pLogSystem;
 	IEntitySystem *pEntitySystem;
+	IUpdateScheduler *pUpdateScheduler;
 	IAssetSystem* pAssetSystem;
 	IObjectFactorySystem* pObjectFactorySystem;
 	IGUISystem* pGUISystem;
@@ -44,6 +45,7 @@ struct SystemTable
 		: pTimeSystem(0)
 		, pLogSystem(0)
 		, pEntitySystem(0)
+		, pUpdateScheduler(0)
 		, pAssetSystem(0)
 		, pObjectFactorySystem(0)
 		, pGUISystem(0)
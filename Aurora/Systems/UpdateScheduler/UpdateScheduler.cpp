@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "UpdateScheduler.h"
+#include "../IUpdateable.h"
+#include "../../RuntimeObjectSystem/IRuntimeObjectSystem.h"
+
+#include <algorithm>
+
+/*
+	Thread safe updateables are gathered into m_ThreadSafe by a first pass over the entities, which is
+	then split into chunks of m_ChunkSize claimed through m_NextChunk by the calling thread and the workers,
+	so a slow chunk does not hold up the others. The workers are created once and wait between frames.
+	Other updateables are updated by a second pass on the calling thread after the parallel work is done,
+	as they may create or destroy entities, which ForEach allows.
+*/
+
+UpdateScheduler::UpdateScheduler()
+	: m_NumThreads( std::max( std::thread::hardware_concurrency(), 1u ) - 1 )
+	, m_ChunkSize( 64 )
+	, m_NextChunk( 0 )
+	, m_DeltaTime( 0.0f )
+	, m_pRuntimeObjectSystem( 0 )
+	, m_Generation( 0 )
+	, m_NumBusy( 0 )
+	, m_bStop( false )
+	, m_bParallelException( false )
+	, m_ModulesLoadedAtException( 0 )
+{
+	m_Collector.m_pScheduler = this;
+	m_Collector.m_pEntitySystem = 0;
+	m_Collector.m_bCollect = true;
+	m_SerialUpdater.m_pScheduler = this;
+	m_SerialUpdater.m_pEntitySystem = 0;
+	m_SerialUpdater.m_bCollect = false;
+	StartThreads();
+}
+
+UpdateScheduler::~UpdateScheduler()
+{
+	StopThreads();
+}
+
+void UpdateScheduler::SetNumThreads(unsigned int numThreads)
+{
+	if( numThreads != m_NumThreads )
+	{
+		StopThreads();
+		m_NumThreads = numThreads;
+		StartThreads();
+	}
+}
+
+unsigned int UpdateScheduler::GetNumThreads() const
+{
+	return m_NumThreads;
+}
+
+void UpdateScheduler::SetChunkSize(unsigned int numUpdateables)
+{
+	m_ChunkSize = std::max( numUpdateables, 1u );
+}
+
+bool UpdateScheduler::Update(IEntitySystem *pEntitySystem, IRuntimeObjectSystem *pRuntimeObjectSystem, float deltaTime)
+{
+	bool bNoException = true;
+	m_DeltaTime = deltaTime;
+	m_pRuntimeObjectSystem = pRuntimeObjectSystem;
+
+	if( m_bParallelException && pRuntimeObjectSystem->GetNumberLoadedModules() != m_ModulesLoadedAtException )
+	{
+		m_bParallelException = false;
+	}
+
+	m_ThreadSafe.clear();
+	if( !m_bParallelException )
+	{
+		m_Collector.m_pEntitySystem = pEntitySystem;
+		if( !pRuntimeObjectSystem->TryProtectedFunction( &m_Collector ) )
+		{
+			// crashed in IsThreadSafe, so don't trust what was gathered
+			m_ThreadSafe.clear();
+			pEntitySystem->AbortIterations();
+			bNoException = false;
+		}
+	}
+
+	if( !m_ThreadSafe.empty() )
+	{
+		const size_t numChunks = ( m_ThreadSafe.size() + m_ChunkSize - 1 ) / m_ChunkSize;
+		const bool bUseThreads = numChunks > 1 && !m_Threads.empty();
+		m_NextChunk = 0;
+
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		if( bUseThreads )
+		{
+			m_NumBusy = (unsigned int)m_Threads.size();
+			++m_Generation;
+			lock.unlock();
+			m_StartCondition.notify_all();
+		}
+		else
+		{
+			lock.unlock();
+		}
+
+		m_Runners[0].m_bJustHadException = !pRuntimeObjectSystem->TryProtectedFunction( &m_Runners[0] );
+
+		lock.lock();
+		while( bUseThreads && m_NumBusy )
+		{
+			m_DoneCondition.wait( lock );
+		}
+		lock.unlock();
+
+		for( size_t i = 0; i < m_Runners.size(); ++i )
+		{
+			if( m_Runners[i].m_bJustHadException )
+			{
+				m_Runners[i].m_bJustHadException = false;
+				m_bParallelException = true;
+				m_ModulesLoadedAtException = pRuntimeObjectSystem->GetNumberLoadedModules();
+				bNoException = false;
+			}
+		}
+	}
+
+	m_SerialUpdater.m_pEntitySystem = pEntitySystem;
+	if( !pRuntimeObjectSystem->TryProtectedFunction( &m_SerialUpdater ) )
+	{
+		pEntitySystem->AbortIterations();
+		bNoException = false;
+	}
+
+	return bNoException;
+}
+
+void UpdateScheduler::StartThreads()
+{
+	m_Runners.resize( m_NumThreads + 1 );
+	for( size_t i = 0; i < m_Runners.size(); ++i )
+	{
+		m_Runners[i].m_pScheduler = this;
+		m_Runners[i].m_bJustHadException = false;
+	}
+
+	// workers only start work when m_Generation moves on from its value now
+	for( unsigned int i = 1; i <= m_NumThreads; ++i )
+	{
+		m_Threads.push_back( std::thread( WorkerThread, this, i, m_Generation ) );
+	}
+}
+
+void UpdateScheduler::StopThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_bStop = true;
+	}
+	m_StartCondition.notify_all();
+	for( size_t i = 0; i < m_Threads.size(); ++i )
+	{
+		m_Threads[i].join();
+	}
+	m_Threads.clear();
+	m_bStop = false;
+}
+
+void UpdateScheduler::WorkerThread(UpdateScheduler *pScheduler, unsigned int runner, unsigned int generation)
+{
+	ChunkRunner& chunkRunner = pScheduler->m_Runners[ runner ];
+	std::unique_lock<std::mutex> lock( pScheduler->m_Mutex );
+	while( true )
+	{
+		while( !pScheduler->m_bStop && pScheduler->m_Generation == generation )
+		{
+			pScheduler->m_StartCondition.wait( lock );
+		}
+		if( pScheduler->m_bStop )
+		{
+			return;
+		}
+		generation = pScheduler->m_Generation;
+		lock.unlock();
+
+		chunkRunner.m_bJustHadException = !pScheduler->m_pRuntimeObjectSystem->TryProtectedFunction( &chunkRunner );
+
+		lock.lock();
+		if( --pScheduler->m_NumBusy == 0 )
+		{
+			pScheduler->m_DoneCondition.notify_one();
+		}
+	}
+}
+
+void UpdateScheduler::RunChunks()
+{
+	const size_t numUpdateables = m_ThreadSafe.size();
+	while( true )
+	{
+		const size_t begin = (size_t)m_NextChunk++ * m_ChunkSize;
+		if( begin >= numUpdateables )
+		{
+			return;
+		}
+		const size_t end = std::min( begin + m_ChunkSize, numUpdateables );
+		for( size_t i = begin; i < end; ++i )
+		{
+			// If dropped here after a runtime failure, your crash was likely
+			// somewhere directly in the updateable's Update method
+			m_ThreadSafe[i]->Update( m_DeltaTime );
+		}
+	}
+}
+
+void UpdateScheduler::ChunkRunner::ProtectedFunc()
+{
+	m_pScheduler->RunChunks();
+}
+
+void UpdateScheduler::EntityPass::ProtectedFunc()
+{
+	// entities deleted during this update by another object are not visited
+	m_pEntitySystem->ForEach( *this, AU_ENTITY_FILTER_UPDATEABLE );
+}
+
+void UpdateScheduler::EntityPass::Visit(IAUEntity* pEnt)
+{
+	IAUUpdateable* pUpdateable = pEnt->GetUpdateable();
+	if( m_bCollect )
+	{
+		if( pUpdateable->IsThreadSafe() )
+		{
+			m_pScheduler->m_ThreadSafe.push_back( pUpdateable );
+		}
+	}
+	else if( !pUpdateable->IsThreadSafe() )
+	{
+		// If dropped here after a runtime failure, your crash was likely
+		// somewhere directly in the updateable's Update method
+		pUpdateable->Update( m_pScheduler->m_DeltaTime );
+	}
+}
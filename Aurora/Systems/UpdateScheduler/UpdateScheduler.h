@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2010-2011 Matthew Jack and Doug Binks
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#pragma once
+
+#ifndef UPDATESCHEDULER_INCLUDED
+#define UPDATESCHEDULER_INCLUDED
+
+#include "../IUpdateScheduler.h"
+#include "../IEntitySystem.h"
+#include "../../RuntimeObjectSystem/RuntimeProtector.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class UpdateScheduler : public IUpdateScheduler
+{
+public:
+	UpdateScheduler();
+	~UpdateScheduler();
+
+	// IUpdateScheduler
+	void SetNumThreads(unsigned int numThreads);
+	unsigned int GetNumThreads() const;
+	void SetChunkSize(unsigned int numUpdateables);
+	bool Update(IEntitySystem *pEntitySystem, IRuntimeObjectSystem *pRuntimeObjectSystem, float deltaTime);
+
+private:
+	// Gathers thread safe updateables, or updates the others serially, on the calling thread
+	struct EntityPass : public RuntimeProtector, public IAUEntityVisitor
+	{
+		UpdateScheduler*	m_pScheduler;
+		IEntitySystem*		m_pEntitySystem;
+		bool				m_bCollect;
+
+		virtual void ProtectedFunc();
+		virtual void Visit(IAUEntity* pEnt);
+	};
+
+	// Updates chunks of m_ThreadSafe until none are left, one per thread
+	struct ChunkRunner : public RuntimeProtector
+	{
+		UpdateScheduler*	m_pScheduler;
+		bool				m_bJustHadException;
+
+		virtual void ProtectedFunc();
+	};
+
+	void StartThreads();
+	void StopThreads();
+	static void WorkerThread(UpdateScheduler *pScheduler, unsigned int runner, unsigned int generation);
+	void RunChunks();
+
+	unsigned int					m_NumThreads;
+	unsigned int					m_ChunkSize;
+	std::vector<std::thread>		m_Threads;
+	std::vector<ChunkRunner>		m_Runners;		// runner 0 is used by the calling thread
+	EntityPass						m_Collector;
+	EntityPass						m_SerialUpdater;
+
+	// Work for the current Update, valid while workers are running
+	std::vector<IAUUpdateable*>		m_ThreadSafe;
+	std::atomic<unsigned int>		m_NextChunk;
+	float							m_DeltaTime;
+	IRuntimeObjectSystem*			m_pRuntimeObjectSystem;
+
+	// Workers wait for m_Generation to change, the calling thread waits for m_NumBusy to reach 0
+	std::mutex						m_Mutex;
+	std::condition_variable			m_StartCondition;
+	std::condition_variable			m_DoneCondition;
+	unsigned int					m_Generation;
+	unsigned int					m_NumBusy;
+	bool							m_bStop;
+
+	// After a crash in a thread safe update they are not run again until a new module is loaded,
+	// as the crashing update may otherwise be retried on a different thread every frame
+	bool							m_bParallelException;
+	unsigned int					m_ModulesLoadedAtException;
+};
+
+#endif // UPDATESCHEDULER_INCLUDED
\ No newline at end of file
@@ -60,5 +60,10 @@ if(BUILD_EXAMPLES)
 	#
 	#aux_source_directory(Systems Systems_SRCS)
 	file(GLOB_RECURSE Systems_SRCS "Systems/*.cpp")
+	if(UNIX)
+		list(REMOVE_ITEM Systems_SRCS "${CMAKE_CURRENT_SOURCE_DIR}/Systems/LogSystem/ThreadsafeLogSystem/ThreadsafeLogSystem_PlatformWindows.cpp")
+	else()
+		list(REMOVE_ITEM Systems_SRCS "${CMAKE_CURRENT_SOURCE_DIR}/Systems/LogSystem/ThreadsafeLogSystem/ThreadsafeLogSystem_PlatformPosix.cpp")
+	endif()
 endif()
 